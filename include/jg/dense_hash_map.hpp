@@ -3,16 +3,27 @@
 
 #include "details/bucket_iterator.hpp"
 #include "details/dense_hash_map_iterator.hpp"
+#include "details/erase_policies.hpp"
 #include "details/node.hpp"
+#include "details/node_handle.hpp"
+#include "details/parallel.hpp"
 #include "details/power_of_two_growth_policy.hpp"
+#include "details/prefetch.hpp"
+#include "details/radix_sort.hpp"
+#include "details/segmented_nodes_container_policy.hpp"
+#include "details/stable_handles.hpp"
 #include "details/type_traits.hpp"
+#include "details/vector_nodes_container_policy.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -23,6 +34,20 @@ namespace details
 {
     static constexpr const float default_max_load_factor = 0.875f;
 
+    // Amount of keys hashed and prefetched together by the batched lookups.
+    static constexpr const std::size_t lookup_batch_size = 16u;
+
+    // From that many elements, bulk insertions first sort the elements by bucket index.
+    static constexpr const std::size_t radix_build_threshold = 65536u;
+
+    // Below one element for that many buckets, resetting the buckets used by the elements is
+    // cheaper than filling the whole bucket array.
+    static constexpr const std::size_t sparse_clear_factor = 16u;
+
+    // From one erased element for that many elements, erasing a batch of keys compacts the nodes
+    // and rebuilds the buckets instead of erasing the elements one by one.
+    static constexpr const std::size_t bulk_erase_factor = 8u;
+
     template <
         class Key, class T, class Container, bool isConst, bool projectToConstKey, class Nodes>
     [[nodiscard]] constexpr auto bucket_iterator_to_iterator(
@@ -32,12 +57,12 @@ namespace details
         if (bucket_it.current_node_index() == details::node_end_index<Key, T>)
         {
             return dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>{
-                nodes.end()};
+                nodes.end(), nodes.end()};
         }
         else
         {
             return dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>{
-                std::next(nodes.begin(), bucket_it.current_node_index())};
+                std::next(nodes.begin(), bucket_it.current_node_index()), nodes.end()};
         }
     }
 
@@ -57,6 +82,19 @@ namespace details
     template <class Pred>
     inline constexpr bool is_transparent_v = is_detected<detect_is_transparent, Pred>::value;
 
+    // Heterogeneous lookups are enabled either by a Hash::transparent_key_equal naming the key
+    // equal to use, or like in C++20 by an is_transparent tag on both the hasher and the key equal.
+    template <class Hash, class Pred>
+    inline constexpr bool is_transparent_lookup_v =
+        is_transparent_key_equal_v<Hash> || (is_transparent_v<Hash> && is_transparent_v<Pred>);
+
+    // A key of another type than Key that the hasher and the key equal both take as it is.
+    template <class Hash, class KeyEqual, class Key, class K>
+    inline constexpr bool is_heterogeneous_key_v =
+        !std::is_same_v<std::remove_cv_t<std::remove_reference_t<K>>, Key> &&
+        std::is_invocable_v<const Hash&, const K&> &&
+        std::is_invocable_r_v<bool, const KeyEqual&, const Key&, const K&>;
+
     template <class Hash, class Pred, class Key, bool = is_transparent_key_equal_v<Hash>>
     struct key_equal
     {
@@ -87,6 +125,15 @@ namespace details
     template <class InputIt>
     using iter_to_alloc_t = std::pair<std::add_const_t<iter_key_t<InputIt>>, iter_val_t<InputIt>>;
 
+    template <class InputIt>
+    inline constexpr bool is_forward_iterator_v = std::is_base_of_v<
+        std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>;
+
+    template <class InputIt>
+    inline constexpr bool is_random_access_iterator_v = std::is_base_of_v<
+        std::random_access_iterator_tag,
+        typename std::iterator_traits<InputIt>::iterator_category>;
+
     template <class Alloc>
     using detect_allocate = decltype(std::declval<Alloc&>().allocate(std::size_t{}));
 
@@ -110,18 +157,48 @@ namespace details
     template <class It>
     using require_input_iterator = std::enable_if_t<!std::is_integral_v<It>>;
 
+    struct identity
+    {
+        template <class T>
+        constexpr auto operator()(T&& t) const noexcept -> T&&
+        {
+            return std::forward<T>(t);
+        }
+    };
+
 } // namespace details
 
+// A hash computed once by dense_hash_map::hash_key. It can be given to the pre-hashed overloads of
+// any map using an equivalent hasher, which then skip hashing the key again.
+struct precomputed_hash
+{
+    std::size_t value;
+};
+
+// Tag for the constructor of dense_hash_map taking a range that the caller guarantees to be free of
+// duplicate keys.
+struct unique_keys_t
+{
+    explicit unique_keys_t() = default;
+};
+
+inline constexpr unique_keys_t unique_keys{};
+
 template <
     class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>,
     class Allocator = std::allocator<std::pair<const Key, T>>,
-    class GrowthPolicy = details::power_of_two_growth_policy>
+    class GrowthPolicy = details::power_of_two_growth_policy,
+    class NodesContainerPolicy = details::vector_nodes_container_policy,
+    class ErasePolicy = details::swap_with_last_erase_policy>
 class dense_hash_map : private GrowthPolicy
 {
+    template <class, class, class, class, class, class, class, class>
+    friend class dense_hash_map;
+
 private:
-    using node_type = details::node<Key, T>;
-    using nodes_container_type =
-        std::vector<node_type, details::rebind_alloc<Allocator, node_type>>;
+    using stored_node_type = details::node<Key, T, std::pair<Key, T>, ErasePolicy>;
+    using nodes_container_type = typename NodesContainerPolicy::template container<
+        stored_node_type, details::rebind_alloc<Allocator, stored_node_type>>;
     using nodes_size_type = typename nodes_container_type::size_type;
     using buckets_container_type =
         std::vector<nodes_size_type, details::rebind_alloc<Allocator, nodes_size_type>>;
@@ -132,6 +209,30 @@ private:
     using deduced_key_equal = typename details::key_equal<Hash, Pred, Key>::type;
 
     static inline constexpr node_index_type node_end_index = details::node_end_index<Key, T>;
+    static inline constexpr bool has_back_links = details::has_back_links_v<ErasePolicy>;
+    static inline constexpr bool has_tombstones = details::has_tombstones_v<ErasePolicy>;
+    static inline constexpr bool has_stable_handles = details::has_stable_handles_v<ErasePolicy>;
+    static inline constexpr bool keeps_insertion_order =
+        details::has_insertion_order_v<ErasePolicy>;
+
+    // Keys of another type are taken as they are by the lookups, and only converted to key_type
+    // when a node gets constructed.
+    template <class K>
+    static inline constexpr bool is_transparent_key_v =
+        details::is_transparent_lookup_v<Hash, Pred> &&
+        details::is_heterogeneous_key_v<Hash, deduced_key_equal, Key, K>;
+
+    template <class K>
+    static inline constexpr bool is_lookup_key_v =
+        std::is_same_v<std::decay_t<K>, Key> || is_transparent_key_v<K>;
+
+    static_assert(
+        !keeps_insertion_order || has_tombstones,
+        "Keeping the insertion order requires an erase policy with tombstones.");
+
+    static_assert(
+        std::is_same_v<nodes_size_type, node_index_type>,
+        "The nodes container must use the same size_type as the node indices.");
 
     static inline constexpr bool is_nothrow_move_constructible =
         std::allocator_traits<Allocator>::is_always_equal::value &&
@@ -174,6 +275,9 @@ public:
         details::dense_hash_map_iterator<Key, T, nodes_container_type, true, true>;
     using local_iterator = details::bucket_iterator<Key, T, nodes_container_type, false, true>;
     using const_local_iterator = details::bucket_iterator<Key, T, nodes_container_type, true, true>;
+    using handle_type = stable_handle;
+    using node_type = details::node_handle<Key, T, Allocator>;
+    using insert_return_type = details::insert_return_type<iterator, node_type>;
 
     constexpr dense_hash_map() noexcept(is_nothrow_default_constructible)
         : dense_hash_map(minimum_capacity())
@@ -182,7 +286,7 @@ public:
     constexpr explicit dense_hash_map(
         size_type bucket_count, const Hash& hash = Hash(), const key_equal& equal = key_equal(),
         const allocator_type& alloc = allocator_type())
-        : hash_(hash), key_equal_(equal), buckets_(alloc), nodes_(alloc)
+        : hash_(hash), key_equal_(equal), buckets_(alloc), nodes_(alloc), slots_(alloc)
     {
         rehash(bucket_count);
     }
@@ -223,6 +327,36 @@ public:
         : dense_hash_map(first, last, bucket_count, hash, key_equal(), alloc)
     {}
 
+    template <class InputIt>
+    constexpr dense_hash_map(
+        unique_keys_t, InputIt first, InputIt last, size_type bucket_count = minimum_capacity(),
+        const Hash& hash = Hash(), const key_equal& equal = key_equal(),
+        const allocator_type& alloc = allocator_type())
+        : dense_hash_map(bucket_count, hash, equal, alloc)
+    {
+        insert_unique_unchecked(first, last);
+    }
+
+    template <class InputIt>
+    dense_hash_map(
+        parallel_policy policy, InputIt first, InputIt last,
+        size_type bucket_count = minimum_capacity(), const Hash& hash = Hash(),
+        const key_equal& equal = key_equal(), const allocator_type& alloc = allocator_type())
+        : dense_hash_map(bucket_count, hash, equal, alloc)
+    {
+        insert(policy, first, last);
+    }
+
+    template <class InputIt>
+    dense_hash_map(
+        parallel_policy policy, unique_keys_t, InputIt first, InputIt last,
+        size_type bucket_count = minimum_capacity(), const Hash& hash = Hash(),
+        const key_equal& equal = key_equal(), const allocator_type& alloc = allocator_type())
+        : dense_hash_map(bucket_count, hash, equal, alloc)
+    {
+        insert_unique_unchecked(policy, first, last);
+    }
+
     constexpr dense_hash_map(const dense_hash_map& other)
         : dense_hash_map(
               other, std::allocator_traits<allocator_type>::select_on_container_copy_construction(
@@ -234,6 +368,8 @@ public:
         , key_equal_(other.key_equal_)
         , buckets_(other.buckets_, alloc)
         , nodes_(other.nodes_, alloc)
+        , dead_nodes_(other.dead_nodes_)
+        , slots_(other.slots_, alloc)
     {}
 
     constexpr dense_hash_map(dense_hash_map&& other) noexcept(is_nothrow_move_constructible) =
@@ -244,6 +380,8 @@ public:
         , key_equal_(std::move(other.key_equal_))
         , buckets_(std::move(other.buckets_), alloc)
         , nodes_(std::move(other.nodes_), alloc)
+        , dead_nodes_(std::move(other.dead_nodes_))
+        , slots_(std::move(other.slots_), alloc)
     {}
 
     constexpr dense_hash_map(
@@ -289,37 +427,69 @@ public:
 
     constexpr auto get_allocator() const -> allocator_type { return buckets_.get_allocator(); }
 
-    constexpr auto begin() noexcept -> iterator { return iterator{nodes_.begin()}; }
+    constexpr auto begin() noexcept -> iterator { return iterator_at(dead_prefix()); }
 
-    constexpr auto begin() const noexcept -> const_iterator
-    {
-        return const_iterator{nodes_.begin()};
-    }
+    constexpr auto begin() const noexcept -> const_iterator { return iterator_at(dead_prefix()); }
 
-    constexpr auto cbegin() const noexcept -> const_iterator
-    {
-        return const_iterator{nodes_.cbegin()};
-    }
+    constexpr auto cbegin() const noexcept -> const_iterator { return begin(); }
 
-    constexpr auto end() noexcept -> iterator { return iterator{nodes_.end()}; }
+    constexpr auto end() noexcept -> iterator { return iterator{nodes_.end(), nodes_.end()}; }
 
-    constexpr auto end() const noexcept -> const_iterator { return const_iterator{nodes_.end()}; }
+    constexpr auto end() const noexcept -> const_iterator
+    {
+        return const_iterator{nodes_.end(), nodes_.end()};
+    }
 
-    constexpr auto cend() const noexcept -> const_iterator { return const_iterator{nodes_.cend()}; }
+    constexpr auto cend() const noexcept -> const_iterator { return end(); }
 
-    [[nodiscard]] constexpr auto empty() const noexcept -> bool { return nodes_.empty(); }
+    // Counts the live elements, since the nodes left may all be dead ones.
+    [[nodiscard]] constexpr auto empty() const noexcept -> bool { return size() == 0u; }
 
-    constexpr auto size() const noexcept -> size_type { return nodes_.size(); }
+    constexpr auto size() const noexcept -> size_type { return nodes_.size() - dead_node_count(); }
 
-    constexpr auto max_size() const noexcept -> size_type { return nodes_.max_size(); }
+    constexpr auto max_size() const noexcept -> size_type
+    {
+        if constexpr (has_stable_handles)
+        {
+            return std::min<size_type>(nodes_.max_size(), details::no_slot);
+        }
+        else
+        {
+            return nodes_.max_size();
+        }
+    }
 
     constexpr void clear() noexcept
     {
         nodes_.clear();
+        reset_dead_node_count();
+        release_all_slots();
         buckets_.clear();
         rehash(0u);
     }
 
+    // Removes all the elements like clear() but keeps the bucket count and the nodes capacity, so
+    // that a map refilled over and over does not pay for the rehashes again. Only the buckets used
+    // by the elements are reset when the map is sparse.
+    constexpr void clear_keep_capacity()
+    {
+        if (size() * details::sparse_clear_factor < bucket_count())
+        {
+            for (const auto& node : nodes_)
+            {
+                buckets_[bucket_index(node.pair.const_key_pair().first)] = node_end_index;
+            }
+        }
+        else
+        {
+            std::fill(buckets_.begin(), buckets_.end(), node_end_index);
+        }
+
+        nodes_.clear();
+        reset_dead_node_count();
+        release_all_slots();
+    }
+
     constexpr auto insert(const value_type& value) -> std::pair<iterator, bool>
     {
         return emplace(value);
@@ -352,12 +522,136 @@ public:
         return insert(std::move(value)).first;
     }
 
+    // Moves the element of a node handle into the map. The handle is left untouched when the key
+    // is already in the map, and is handed back in the returned insert_return_type.
+    auto insert(node_type&& node) -> insert_return_type
+    {
+        if (node.empty())
+        {
+            return {end(), false, node_type{}};
+        }
+
+        auto& pair = *node.pair_;
+        const auto result = do_emplace(pair.first, std::move(pair));
+
+        if (!result.second)
+        {
+            return {result.first, false, std::move(node)};
+        }
+
+        node.reset();
+        return {result.first, true, node_type{}};
+    }
+
+    auto insert(const_iterator /*hint*/, node_type&& node) -> iterator
+    {
+        return insert(std::move(node)).position;
+    }
+
+    // With forward iterators, both containers are sized once up front and the keys are hashed in
+    // batches, without any growth check per element. What a range mostly made of duplicate keys
+    // did not use is given back afterwards.
     template <class InputIt>
     constexpr void insert(InputIt first, InputIt last)
     {
+        if constexpr (details::is_forward_iterator_v<InputIt>)
+        {
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            const auto reservation = save_reservation();
+            grow_for(size() + count);
+
+            if constexpr (std::is_same_v<
+                              details::detected_t<details::iter_key_t, InputIt>, key_type>)
+            {
+                insert_reserved(first, count);
+            }
+            else
+            {
+                for (; first != last; ++first)
+                {
+                    insert(*first);
+                }
+            }
+
+            release_unused_reservation(reservation, count);
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                insert(*first);
+            }
+        }
+    }
+
+    // Same as above but reserves room for size_hint more elements first, which avoids the
+    // intermediate rehashes with input iterators whose length cannot be known up front.
+    template <class InputIt>
+    constexpr void insert(InputIt first, InputIt last, size_type size_hint)
+    {
+        grow_for(size() + size_hint);
+        insert(first, last);
+    }
+
+    // Inserts the pairs of [first, last) without comparing their keys to the ones already stored.
+    // The caller guarantees that the keys are unique within the range and not in the map yet.
+    template <class InputIt>
+    constexpr void insert_unique_unchecked(InputIt first, InputIt last)
+    {
+        if constexpr (details::is_forward_iterator_v<InputIt>)
+        {
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            grow_for(size() + count);
+
+            if constexpr (std::is_same_v<
+                              details::detected_t<details::iter_key_t, InputIt>, key_type>)
+            {
+                insert_reserved<true>(first, count);
+                return;
+            }
+        }
+
         for (; first != last; ++first)
         {
-            insert(*first);
+            check_for_rehash();
+
+            auto&& pair = *first;
+            const auto bindex = bucket_index(pair.first);
+            assert(find_in_bucket(pair.first, bindex) == end(0u) && "Duplicated key.");
+            append_in_bucket(bindex, std::forward<decltype(pair)>(pair));
+        }
+    }
+
+    // Parallel versions of the two range insertions above for random access ranges of pairs. The
+    // elements are hashed, partitioned by bucket range and deduplicated by several threads, the
+    // nodes are then constructed in order and each thread links the chains of its own buckets.
+    // The maps keeping the insertion order insert serially.
+    template <class InputIt>
+    void insert(parallel_policy policy, InputIt first, InputIt last)
+    {
+        if constexpr (is_parallel_buildable_v<InputIt> && !keeps_insertion_order)
+        {
+            const auto count = static_cast<size_type>(last - first);
+            const auto reservation = save_reservation();
+            parallel_insert<false>(policy, first, count);
+            release_unused_reservation(reservation, count);
+        }
+        else
+        {
+            insert(first, last);
+        }
+    }
+
+    template <class InputIt>
+    void insert_unique_unchecked(parallel_policy policy, InputIt first, InputIt last)
+    {
+        if constexpr (is_parallel_buildable_v<InputIt> && !keeps_insertion_order)
+        {
+            parallel_insert<true>(policy, first, static_cast<size_type>(last - first));
+        }
+        else
+        {
+            insert_unique_unchecked(first, last);
         }
     }
 
@@ -392,6 +686,19 @@ public:
         return result;
     }
 
+    template <class K, class M, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto insert_or_assign(K&& k, M&& obj) -> std::pair<iterator, bool>
+    {
+        auto result = try_emplace(std::forward<K>(k), std::forward<M>(obj));
+
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(obj);
+        }
+
+        return result;
+    }
+
     template <class M>
     constexpr auto insert_or_assign(const_iterator /*hint*/, const key_type& k, M&& obj) -> iterator
     {
@@ -404,6 +711,136 @@ public:
         return insert_or_assign(std::move(k), std::forward<M>(obj)).first;
     }
 
+    template <class K, class M, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto insert_or_assign(const_iterator /*hint*/, K&& k, M&& obj) -> iterator
+    {
+        return insert_or_assign(std::forward<K>(k), std::forward<M>(obj)).first;
+    }
+
+    // Inserts value under key, or combines it into the mapped value already there, with a single
+    // hash and chain walk. combine(mapped, value) either updates mapped in place and returns void,
+    // or returns the new mapped value, so that std::plus<> and the likes can be used.
+    template <class K, class V, class Combine>
+    auto upsert(K&& key, V&& value, Combine combine) -> std::pair<iterator, bool>
+    {
+        if constexpr (is_lookup_key_v<K>)
+        {
+            return upsert_hashed(hash_(key), std::forward<K>(key), std::forward<V>(value), combine);
+        }
+        else
+        {
+            return upsert(
+                key_type(std::forward<K>(key)), std::forward<V>(value), std::move(combine));
+        }
+    }
+
+    // Same as upsert, with the hash of key computed beforehand by hash_key.
+    template <class K, class V, class Combine>
+    auto upsert(K&& key, precomputed_hash hash, V&& value, Combine combine)
+        -> std::pair<iterator, bool>
+    {
+        if constexpr (is_lookup_key_v<K>)
+        {
+            return upsert_hashed(hash.value, std::forward<K>(key), std::forward<V>(value), combine);
+        }
+        else
+        {
+            return upsert_hashed(
+                hash.value, key_type(std::forward<K>(key)), std::forward<V>(value), combine);
+        }
+    }
+
+    // Constructs the mapped value from the elements of args if key is not in the map, or calls
+    // visitor(mapped) on the mapped value already there, with a single hash and chain walk.
+    template <class K, class... Args, class Visitor>
+    auto try_emplace_or_visit(K&& key, std::tuple<Args...> args, Visitor visitor)
+        -> std::pair<iterator, bool>
+    {
+        if constexpr (is_lookup_key_v<K>)
+        {
+            return emplace_or_visit_hashed(
+                hash_(key), key, visitor, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)), std::move(args));
+        }
+        else
+        {
+            return try_emplace_or_visit(
+                key_type(std::forward<K>(key)), std::move(args), std::move(visitor));
+        }
+    }
+
+    // Batched upsert over a range of (key, value) pairs, returning how many were inserted. The keys
+    // are hashed and their buckets prefetched a batch ahead of the updates, unless they have to be
+    // converted to key_type first.
+    template <class ForwardIt, class Combine>
+    auto upsert_many(ForwardIt first, ForwardIt last, Combine combine) -> size_type
+    {
+        size_type inserted_count = 0;
+
+        if constexpr (is_lookup_key_v<decltype((*first).first)>)
+        {
+            for_each_prehashed(
+                first, last, [](const auto& pair) -> const auto& { return pair.first; },
+                [&](precomputed_hash hash, auto&& pair) {
+                    using pair_type = decltype(pair);
+                    const auto result = upsert_hashed(
+                        hash.value, std::forward<pair_type>(pair).first,
+                        std::forward<pair_type>(pair).second, combine);
+                    inserted_count += result.second;
+                });
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                auto&& pair = *first;
+                using pair_type = decltype(pair);
+                key_type key(std::forward<pair_type>(pair).first);
+                const auto hash = hash_(key);
+                const auto result = upsert_hashed(
+                    hash, std::move(key), std::forward<pair_type>(pair).second, combine);
+                inserted_count += result.second;
+            }
+        }
+
+        return inserted_count;
+    }
+
+    // Batched try_emplace_or_visit over a range of keys, returning how many were inserted. Every
+    // inserted mapped value is constructed from a copy of args.
+    template <class ForwardIt, class... Args, class Visitor>
+    auto try_emplace_or_visit_many(
+        ForwardIt first, ForwardIt last, const std::tuple<Args...>& args, Visitor visitor)
+        -> size_type
+    {
+        size_type inserted_count = 0;
+
+        if constexpr (is_lookup_key_v<decltype(*first)>)
+        {
+            for_each_prehashed(
+                first, last, details::identity{}, [&](precomputed_hash hash, auto&& key) {
+                    const auto result = emplace_or_visit_hashed(
+                        hash.value, key, visitor, std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<decltype(key)>(key)), args);
+                    inserted_count += result.second;
+                });
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                key_type key(*first);
+                const auto hash = hash_(key);
+                const auto result = emplace_or_visit_hashed(
+                    hash, key, visitor, std::piecewise_construct,
+                    std::forward_as_tuple(std::move(key)), args);
+                inserted_count += result.second;
+            }
+        }
+
+        return inserted_count;
+    }
+
     template <class... Args>
     auto emplace(Args&&... args) -> std::pair<iterator, bool>
     {
@@ -432,25 +869,64 @@ public:
             std::forward_as_tuple(std::forward<Args>(args)...));
     }
 
+    template <class... Args>
+    constexpr auto try_emplace(const key_type& key, precomputed_hash hash, Args&&... args)
+        -> std::pair<iterator, bool>
+    {
+        return do_emplace_hashed(
+            hash.value, key, std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    constexpr auto try_emplace(key_type&& key, precomputed_hash hash, Args&&... args)
+        -> std::pair<iterator, bool>
+    {
+        return do_emplace_hashed(
+            hash.value, key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    // The key is only converted to key_type when it is not in the map yet.
+    template <class K, class... Args, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto try_emplace(K&& key, Args&&... args) -> std::pair<iterator, bool>
+    {
+        return do_emplace(
+            key, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <class K, class... Args, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto try_emplace(K&& key, precomputed_hash hash, Args&&... args)
+        -> std::pair<iterator, bool>
+    {
+        return do_emplace_hashed(
+            hash.value, key, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
     template <class... Args>
     constexpr auto try_emplace(const_iterator /*hint*/, const key_type& key, Args&&... args)
         -> iterator
     {
-        return try_emplace(key, std::forward<Args>(args)...).iterator;
+        return try_emplace(key, std::forward<Args>(args)...).first;
     }
 
     template <class... Args>
     constexpr auto try_emplace(const_iterator /*hint*/, key_type&& key, Args&&... args) -> iterator
     {
-        return try_emplace(std::move(key), std::forward<Args>(args)...).iterator;
+        return try_emplace(std::move(key), std::forward<Args>(args)...).first;
+    }
+
+    template <class K, class... Args, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto try_emplace(const_iterator /*hint*/, K&& key, Args&&... args) -> iterator
+    {
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...).first;
     }
 
     constexpr auto erase(const_iterator pos) -> iterator
     {
-        const auto position = std::distance(cbegin(), pos);
-        const auto it = std::next(begin(), position);
-        const auto previous_next = find_previous_next_using_position(pos->first, position);
-        return do_erase(previous_next, it.sub_iterator()).first;
+        return compact_if_mostly_dead(erase_at(pos.sub_iterator() - nodes_.cbegin()));
     }
 
     constexpr auto erase(const_iterator first, const_iterator last) -> iterator
@@ -460,17 +936,45 @@ public:
         {
             --last;
             stop = first == last; // if first == last, erase would invalidate both!
-            last = erase(last);
+            last = erase_at(last.sub_iterator() - nodes_.cbegin());
         }
 
-        const auto position = std::distance(cbegin(), last);
-        return std::next(begin(), position);
+        return compact_if_mostly_dead(iterator_at(last.sub_iterator() - nodes_.cbegin()));
     }
 
     constexpr auto erase(const key_type& key) -> size_type
+    {
+        return erase(key, precomputed_hash{hash_(key)});
+    }
+
+    constexpr auto erase(const key_type& key, precomputed_hash hash) -> size_type
+    {
+        return erase_key(key, hash);
+    }
+
+    template <
+        class K,
+        std::enable_if_t<
+            is_transparent_key_v<K> && !std::is_convertible_v<K&&, iterator> &&
+                !std::is_convertible_v<K&&, const_iterator>,
+            int> = 0>
+    constexpr auto erase(K&& key) -> size_type
+    {
+        return erase_key(key, precomputed_hash{hash_(key)});
+    }
+
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto erase(const K& key, precomputed_hash hash) -> size_type
+    {
+        return erase_key(key, hash);
+    }
+
+    // Erases the element with the given key, using its hash.
+    template <class K>
+    constexpr auto erase_key(const K& key, precomputed_hash hash) -> size_type
     {
         // We have to find out the node we look for and the pointer to it.
-        const auto bindex = bucket_index(key);
+        const auto bindex = compute_index(hash.value, buckets_.size());
 
         std::size_t* previous_next = &buckets_[bindex];
 
@@ -492,34 +996,239 @@ public:
         }
 
         do_erase(previous_next, std::next(nodes_.begin(), *previous_next));
+        compact_if_mostly_dead();
 
         return 1;
     }
 
-    constexpr void swap(dense_hash_map& other) noexcept(is_nothrow_swappable)
+    // Erases the elements with the keys of [first, last) and returns how many were removed. The
+    // elements are located with the batched lookups of find_many, then either compacted away in a
+    // single pass when they are numerous, or erased from the back so that no victim gets moved.
+    template <class ForwardIt>
+    auto erase_many(ForwardIt first, ForwardIt last) -> size_type
     {
-        using std::swap;
-        swap(buckets_, other.buckets_);
-        swap(nodes_, other.nodes_);
-        swap(max_load_factor_, other.max_load_factor_);
-        swap(hash_, other.hash_);
-        swap(key_equal_, other.key_equal_);
-    }
+        std::vector<node_index_type, details::rebind_alloc<Allocator, node_index_type>> victims(
+            get_allocator());
 
-    constexpr auto at(const key_type& key) -> T&
-    {
-        const auto it = find(key);
+        lookup_many(first, last, [&victims](node_index_type index) {
+            if (index != node_end_index)
+            {
+                victims.push_back(index);
+            }
+        });
 
-        if (it == end())
+        std::sort(victims.begin(), victims.end());
+        victims.erase(std::unique(victims.begin(), victims.end()), victims.end());
+
+        if (victims.size() * details::bulk_erase_factor >= size())
         {
-#ifdef JG_NO_EXCEPTION
-            std::abort();
-#else
-            throw std::out_of_range("The specified key does not exists in this map.");
-#endif
-        }
+            std::vector<char, details::rebind_alloc<Allocator, char>> erased(
+                nodes_.size(), get_allocator());
 
-        return it->second;
+            for (const auto index : victims)
+            {
+                erased[index] = true;
+            }
+
+            return erase_nodes_if(
+                1u, [&erased](const stored_node_type& /*node*/, std::size_t index) {
+                    return erased[index] != 0;
+                });
+        }
+
+        // Going from the back, the last node moved into an erased slot is never a victim itself.
+        for (auto it = victims.rbegin(); it != victims.rend(); ++it)
+        {
+            erase_at(*it);
+        }
+
+        compact_if_mostly_dead();
+
+        return victims.size();
+    }
+
+    // Moves the element at position out of the map into a node handle.
+    auto extract(const_iterator position) -> node_type
+    {
+        const auto index = static_cast<node_index_type>(position.sub_iterator() - nodes_.cbegin());
+
+        // What points to the node is found while its key is still there.
+        std::size_t* previous_next = nullptr;
+
+        if constexpr (!has_back_links)
+        {
+            previous_next = find_previous_next_using_position(
+                nodes_[index].pair.const_key_pair().first, index);
+        }
+
+        node_type node{get_allocator(), std::move(nodes_[index].pair.pair())};
+        do_erase(previous_next, std::next(nodes_.begin(), index));
+        compact_if_mostly_dead();
+
+        return node;
+    }
+
+    auto extract(const key_type& key) -> node_type
+    {
+        const auto it = find(key);
+        return it == end() ? node_type{} : extract(it);
+    }
+
+    // Moves the elements of source whose key is not in this map yet, leaving the others in source.
+    // An empty map takes over the nodes of a source of the same type at once when the allocators
+    // compare equal. Otherwise the elements are moved one by one and source is compacted in a
+    // single pass at the end.
+    template <class Hash2, class Pred2>
+    void merge(dense_hash_map<
+               Key, T, Hash2, Pred2, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>&
+                   source)
+    {
+        using source_type = std::remove_reference_t<decltype(source)>;
+
+        if constexpr (std::is_same_v<source_type, dense_hash_map>)
+        {
+            if (&source == this)
+            {
+                return;
+            }
+
+            // Taking over the slots of the source would give the stale handles of this map a
+            // second life, so the maps with stable handles move their elements one by one.
+            if constexpr (std::is_empty_v<key_equal> && !has_stable_handles)
+            {
+                if (empty() && get_allocator() == source.get_allocator())
+                {
+                    splice_nodes(source);
+                    return;
+                }
+            }
+        }
+
+        std::vector<char, details::rebind_alloc<Allocator, char>> moved(
+            source.nodes_.size(), get_allocator());
+
+        const auto move_nodes = [&] {
+            for (std::size_t index = 0; index < source.nodes_.size(); ++index)
+            {
+                auto& node = source.nodes_[index];
+
+                if (node.is_dead())
+                {
+                    continue;
+                }
+
+                auto& pair = node.pair.pair();
+                moved[index] = do_emplace(pair.first, std::move(pair)).second;
+            }
+        };
+
+        // The moved-from elements cannot be looked up anymore, so they are dropped in bulk.
+        const auto erase_moved = [&] {
+            source.erase_nodes_if(1u, [&moved](const auto& /*node*/, std::size_t index) {
+                return moved[index] != 0;
+            });
+        };
+
+#ifdef JG_NO_EXCEPTION
+        move_nodes();
+#else
+        try
+        {
+            move_nodes();
+        }
+        catch (...)
+        {
+            erase_moved();
+            throw;
+        }
+#endif
+
+        erase_moved();
+    }
+
+    template <class Hash2, class Pred2>
+    void merge(dense_hash_map<
+               Key, T, Hash2, Pred2, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>&&
+                   source)
+    {
+        merge(source);
+    }
+
+    // Removes the elements for which pred(element) is true and returns how many were removed. The
+    // kept nodes are moved toward the front in a single pass, keeping their order, and the buckets
+    // are rebuilt once at the end. pred is evaluated on every element before any node moves, so
+    // that the map is left untouched if it throws.
+    template <class Predicate>
+    auto erase_if(Predicate pred) -> size_type
+    {
+        std::vector<char, details::rebind_alloc<Allocator, char>> erased(
+            nodes_.size(), get_allocator());
+
+        for (std::size_t i = 0; i < nodes_.size(); ++i)
+        {
+            erased[i] = !nodes_[i].is_dead() && pred(nodes_[i].pair.const_key_pair());
+        }
+
+        return erase_nodes_if(1u, [&erased](const stored_node_type& /*node*/, std::size_t index) {
+            return erased[index] != 0;
+        });
+    }
+
+    // Same as above, but pred is evaluated and the buckets are rebuilt by several threads.
+    template <class Predicate>
+    auto erase_if(parallel_policy policy, Predicate pred) -> size_type
+    {
+        const auto thread_count = details::resolve_thread_count(policy, nodes_.size());
+
+        if (thread_count <= 1)
+        {
+            return erase_if(std::move(pred));
+        }
+
+        std::vector<char, details::rebind_alloc<Allocator, char>> erased(
+            nodes_.size(), get_allocator());
+
+        details::parallel_for_chunks(
+            thread_count, nodes_.size(), details::parallel_chunk_size,
+            [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i)
+                {
+                    erased[i] = !nodes_[i].is_dead() && pred(nodes_[i].pair.const_key_pair());
+                }
+            });
+
+        return erase_nodes_if(
+            thread_count, [&erased](const stored_node_type& /*node*/, std::size_t index) {
+                return erased[index] != 0;
+            });
+    }
+
+    constexpr void swap(dense_hash_map& other) noexcept(is_nothrow_swappable)
+    {
+        using std::swap;
+        swap(buckets_, other.buckets_);
+        swap(nodes_, other.nodes_);
+        swap(max_load_factor_, other.max_load_factor_);
+        swap(hash_, other.hash_);
+        swap(key_equal_, other.key_equal_);
+        swap(dead_nodes_, other.dead_nodes_);
+        swap(slots_, other.slots_);
+    }
+
+    constexpr auto at(const key_type& key) -> T&
+    {
+        const auto it = find(key);
+
+        if (it == end())
+        {
+#ifdef JG_NO_EXCEPTION
+            std::abort();
+#else
+            throw std::out_of_range("The specified key does not exists in this map.");
+#endif
+        }
+
+        return it->second;
     }
 
     constexpr auto at(const key_type& key) const -> const T&
@@ -538,6 +1247,40 @@ public:
         return it->second;
     }
 
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto at(const K& key) -> T&
+    {
+        const auto it = find(key);
+
+        if (it == end())
+        {
+#ifdef JG_NO_EXCEPTION
+            std::abort();
+#else
+            throw std::out_of_range("The specified key does not exists in this map.");
+#endif
+        }
+
+        return it->second;
+    }
+
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto at(const K& key) const -> const T&
+    {
+        const auto it = find(key);
+
+        if (it == end())
+        {
+#ifdef JG_NO_EXCEPTION
+            std::abort();
+#else
+            throw std::out_of_range("The specified key does not exists in this map.");
+#endif
+        }
+
+        return it->second;
+    }
+
     constexpr auto operator[](const key_type& key) -> T&
     {
         return this->try_emplace(key).first->second;
@@ -548,13 +1291,19 @@ public:
         return this->try_emplace(std::move(key)).first->second;
     }
 
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto operator[](K&& key) -> T&
+    {
+        return this->try_emplace(std::forward<K>(key)).first->second;
+    }
+
     constexpr auto count(const key_type& key) const -> size_type
     {
         return find(key) == end() ? 0u : 1u;
     }
 
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto count(const K& key) const -> size_type
     {
         return find(key) == end() ? 0u : 1u;
@@ -570,29 +1319,96 @@ public:
         return details::bucket_iterator_to_iterator(find_in_bucket(key, bucket_index(key)), nodes_);
     }
 
+    constexpr auto find(const key_type& key, precomputed_hash hash) -> iterator
+    {
+        return details::bucket_iterator_to_iterator(
+            find_in_bucket(key, compute_index(hash.value, buckets_.size())), nodes_);
+    }
+
+    constexpr auto find(const key_type& key, precomputed_hash hash) const -> const_iterator
+    {
+        return details::bucket_iterator_to_iterator(
+            find_in_bucket(key, compute_index(hash.value, buckets_.size())), nodes_);
+    }
+
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto find(const K& key) -> iterator
     {
         return details::bucket_iterator_to_iterator(find_in_bucket(key, bucket_index(key)), nodes_);
     }
 
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto find(const K& key) const -> const_iterator
     {
         return details::bucket_iterator_to_iterator(find_in_bucket(key, bucket_index(key)), nodes_);
     }
 
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto find(const K& key, precomputed_hash hash) -> iterator
+    {
+        return details::bucket_iterator_to_iterator(
+            find_in_bucket(key, compute_index(hash.value, buckets_.size())), nodes_);
+    }
+
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto find(const K& key, precomputed_hash hash) const -> const_iterator
+    {
+        return details::bucket_iterator_to_iterator(
+            find_in_bucket(key, compute_index(hash.value, buckets_.size())), nodes_);
+    }
+
+    // Looks up every key of [first, last) and writes the resulting iterators to out. The keys are
+    // processed in small batches: all the buckets of a batch are prefetched, then the first node of
+    // every chain, before walking the chains. This overlaps the cache misses of the lookups.
+    template <class ForwardIt, class OutputIt>
+    constexpr auto find_many(ForwardIt first, ForwardIt last, OutputIt out) -> OutputIt
+    {
+        lookup_many(first, last, [this, &out](node_index_type index) {
+            *out++ = index == node_end_index ? end() : iterator_at(index);
+        });
+        return out;
+    }
+
+    template <class ForwardIt, class OutputIt>
+    constexpr auto find_many(ForwardIt first, ForwardIt last, OutputIt out) const -> OutputIt
+    {
+        lookup_many(first, last, [this, &out](node_index_type index) {
+            *out++ = index == node_end_index ? end() : iterator_at(index);
+        });
+        return out;
+    }
+
+    // Same as find_many but writes whether each key is in the map.
+    template <class ForwardIt, class OutputIt>
+    constexpr auto contains_many(ForwardIt first, ForwardIt last, OutputIt out) const -> OutputIt
+    {
+        lookup_many(
+            first, last, [&out](node_index_type index) { *out++ = index != node_end_index; });
+        return out;
+    }
+
     constexpr auto contains(const key_type& key) const -> bool { return find(key) != end(); }
 
+    constexpr auto contains(const key_type& key, precomputed_hash hash) const -> bool
+    {
+        return find(key, hash) != end();
+    }
+
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto contains(const K& key) const -> bool
     {
         return find(key) != end();
     }
 
+    template <class K, std::enable_if_t<is_transparent_key_v<K>, int> = 0>
+    constexpr auto contains(const K& key, precomputed_hash hash) const -> bool
+    {
+        return find(key, hash) != end();
+    }
+
     constexpr auto equal_range(const Key& key) -> std::pair<iterator, iterator>
     {
         const auto it = find(key);
@@ -618,7 +1434,7 @@ public:
     }
 
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto equal_range(const K& key) -> std::pair<iterator, iterator>
     {
         const auto it = find(key);
@@ -632,257 +1448,1476 @@ public:
     }
 
     template <
-        class K, class Useless = std::enable_if_t<details::is_transparent_key_equal_v<Hash>, K>>
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
     constexpr auto equal_range(const K& key) const -> std::pair<const_iterator, const_iterator>
     {
-        const auto it = find(key);
-
-        if (it == end())
+        const auto it = find(key);
+
+        if (it == end())
+        {
+            return {it, it};
+        }
+
+        return {it, std::next(it)};
+    }
+
+    // Parallel algorithms over the elements. The nodes are split into chunks which the threads
+    // claim as they go, so that a slow chunk does not hold the other threads back. The elements
+    // are visited in no particular order.
+    template <class F>
+    void for_each(parallel_policy policy, F f)
+    {
+        for_each_node(policy, [&f](stored_node_type& node) { f(node.pair.const_key_pair()); });
+    }
+
+    template <class F>
+    void for_each(parallel_policy policy, F f) const
+    {
+        for_each_node(
+            policy, [&f](const stored_node_type& node) { f(node.pair.const_key_pair()); });
+    }
+
+    // Replaces every mapped value by f(element).
+    template <class F>
+    void transform_values(parallel_policy policy, F f)
+    {
+        for_each_node(policy, [&f](stored_node_type& node) {
+            auto& pair = node.pair.const_key_pair();
+            pair.second = f(std::as_const(pair));
+        });
+    }
+
+    // Combines init with transform_op(element) for every element using reduce_op, which must be
+    // associative. The partial results of the chunks are combined in order.
+    template <class U, class BinaryOp, class UnaryOp>
+    auto reduce(parallel_policy policy, U init, BinaryOp reduce_op, UnaryOp transform_op) const
+        -> U
+    {
+        const auto chunk_count =
+            (nodes_.size() + details::parallel_chunk_size - 1) / details::parallel_chunk_size;
+        std::vector<std::optional<U>, details::rebind_alloc<Allocator, std::optional<U>>> partials(
+            chunk_count, get_allocator());
+
+        details::parallel_for_chunks(
+            details::resolve_thread_count(policy, nodes_.size()), nodes_.size(),
+            details::parallel_chunk_size, [&](std::size_t begin, std::size_t end) {
+                auto& partial = partials[begin / details::parallel_chunk_size];
+
+                for (auto i = begin; i < end; ++i)
+                {
+                    if (nodes_[i].is_dead())
+                    {
+                        continue;
+                    }
+
+                    if (partial)
+                    {
+                        partial = reduce_op(
+                            std::move(*partial), transform_op(nodes_[i].pair.const_key_pair()));
+                    }
+                    else
+                    {
+                        partial.emplace(transform_op(nodes_[i].pair.const_key_pair()));
+                    }
+                }
+            });
+
+        for (auto& partial : partials)
+        {
+            if (partial)
+            {
+                init = reduce_op(std::move(init), std::move(*partial));
+            }
+        }
+
+        return init;
+    }
+
+    constexpr auto begin(size_type n) -> local_iterator
+    {
+        return local_iterator{buckets_[n], nodes_};
+    }
+
+    constexpr auto begin(size_type n) const -> const_local_iterator
+    {
+        return const_local_iterator{buckets_[n], nodes_};
+    }
+
+    constexpr auto cbegin(size_type n) const -> const_local_iterator
+    {
+        return const_local_iterator{buckets_[n], nodes_};
+    }
+
+    constexpr auto end(size_type /*n*/) -> local_iterator { return local_iterator{nodes_}; }
+
+    constexpr auto end(size_type /*n*/) const -> const_local_iterator
+    {
+        return const_local_iterator{nodes_};
+    }
+
+    constexpr auto cend(size_type /*n*/) const -> const_local_iterator
+    {
+        return const_local_iterator{nodes_};
+    }
+
+    constexpr auto bucket_count() const -> size_type { return buckets_.size(); }
+
+    constexpr auto max_bucket_count() const -> size_type { return buckets_.max_size(); }
+
+    constexpr auto bucket_size(size_type n) const -> size_type
+    {
+        return static_cast<size_t>(std::distance(begin(n), end(n)));
+    }
+
+    constexpr auto bucket(const key_type& key) const -> size_type { return bucket_index(key); }
+
+    constexpr auto load_factor() const -> float
+    {
+        return size() / static_cast<float>(bucket_count());
+    }
+
+    constexpr auto max_load_factor() const -> float { return max_load_factor_; }
+
+    constexpr void max_load_factor(float ml)
+    {
+        assert(ml > 0.0f && "The max load factor must be greater than 0.0f.");
+        max_load_factor_ = ml;
+        rehash(8);
+    }
+
+    constexpr void rehash(size_type count) { do_rehash(count, 1u); }
+
+    // Same as rehash, but the nodes are relinked by several threads, each of them owning a range of
+    // the new buckets. Growing a power of two bucket count splits the chains in place, any other
+    // rehash takes 24 bytes of scratch per element.
+    void rehash(parallel_policy policy, size_type count)
+    {
+        do_rehash(count, details::resolve_thread_count(policy, size()));
+    }
+
+    constexpr void reserve(std::size_t count)
+    {
+        rehash(std::ceil(count / max_load_factor()));
+        nodes_.reserve(count);
+    }
+
+    void reserve(parallel_policy policy, std::size_t count)
+    {
+        rehash(policy, std::ceil(count / max_load_factor()));
+        nodes_.reserve(count);
+    }
+
+    // Removes the dead nodes left by the erasures under a tombstone erase policy, keeping the order
+    // of the elements. This invalidates the iterators.
+    void compact()
+    {
+        if (dead_node_count() > 0u)
+        {
+            erase_nodes_if(1u, [](const stored_node_type& /*node*/, std::size_t /*index*/) {
+                return false;
+            });
+        }
+    }
+
+    // The handle to the element at pos, which must be dereferenceable. Requires an erase policy
+    // with stable handles.
+    constexpr auto handle_of(const_iterator pos) const noexcept -> handle_type
+    {
+        static_assert(has_stable_handles, "The erase policy does not provide stable handles.");
+        return slots_.handle(pos.sub_iterator()->slot);
+    }
+
+    // The element a handle refers to, or end() once that element was erased.
+    constexpr auto resolve(handle_type handle) noexcept -> iterator
+    {
+        static_assert(has_stable_handles, "The erase policy does not provide stable handles.");
+        const auto index = slots_.node_index(handle);
+        return index == details::no_slot ? end() : iterator_at(index);
+    }
+
+    constexpr auto resolve(handle_type handle) const noexcept -> const_iterator
+    {
+        static_assert(has_stable_handles, "The erase policy does not provide stable handles.");
+        const auto index = slots_.node_index(handle);
+        return index == details::no_slot ? end() : iterator_at(index);
+    }
+
+    // Gives back the memory that is not needed anymore, typically after a large erase sweep: the
+    // buckets are shrunk to the smallest count honoring the max load factor and the nodes container
+    // releases its spare capacity.
+    constexpr void shrink_to_fit()
+    {
+        compact();
+        rehash(0u);
+        buckets_.shrink_to_fit();
+        nodes_.shrink_to_fit();
+    }
+
+    constexpr auto hash_function() const -> hasher { return hash_; }
+
+    // Hashes a key once for the pre-hashed overloads of find, contains, try_emplace, upsert and
+    // erase.
+    constexpr auto hash_key(const key_type& key) const -> precomputed_hash
+    {
+        return precomputed_hash{hash_(key)};
+    }
+
+    template <
+        class K, class Useless = std::enable_if_t<details::is_transparent_lookup_v<Hash, Pred>, K>>
+    constexpr auto hash_key(const K& key) const -> precomputed_hash
+    {
+        return precomputed_hash{hash_(key)};
+    }
+
+    // Starts loading the bucket of a pre-hashed key, to be followed by a lookup a bit later.
+    void prefetch(precomputed_hash hash) const noexcept
+    {
+        details::prefetch(&buckets_[compute_index(hash.value, buckets_.size())]);
+    }
+
+    // Calls f(hash, element) for every element of [first, last), in order, hash being the one of
+    // key_of(element). The keys are hashed and their buckets prefetched a batch at a time, so that
+    // f can look them up with the pre-hashed overloads without waiting on memory. key_of must give
+    // a key_type, or any key with a transparent hasher.
+    template <class ForwardIt, class KeyOf, class F>
+    void for_each_prehashed(ForwardIt first, ForwardIt last, const KeyOf& key_of, const F& f) const
+    {
+        precomputed_hash hashes[details::lookup_batch_size];
+
+        while (first != last)
+        {
+            std::size_t count = 0;
+
+            for (auto it = first; it != last && count < details::lookup_batch_size; ++it)
+            {
+                hashes[count++] = precomputed_hash{hash_(key_of(*it))};
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                prefetch(hashes[i]);
+            }
+
+            for (std::size_t i = 0; i < count; ++i, ++first)
+            {
+                f(hashes[i], *first);
+            }
+        }
+    }
+
+    constexpr auto key_eq() const -> key_equal { return key_equal_; }
+
+private:
+    template <class K>
+    constexpr auto bucket_index(const K& key) const -> size_type
+    {
+        return compute_index(hash_(key), buckets_.size());
+    }
+
+    template <class K>
+    constexpr auto find_in_bucket(const K& key, std::size_t bucket_index) -> local_iterator
+    {
+        auto b = begin(bucket_index);
+        auto e = end(0u);
+        auto it = std::find_if(b, e, [&key, this](auto& p) { return key_equal_(p.first, key); });
+        return it;
+    }
+
+    template <class K>
+    constexpr auto find_in_bucket(const K& key, std::size_t bucket_index) const
+        -> const_local_iterator
+    {
+        auto b = begin(bucket_index);
+        auto e = end(0u);
+        auto it = std::find_if(b, e, [&key, this](auto& p) { return key_equal_(p.first, key); });
+        return it;
+    }
+
+    template <class ForwardIt, class F>
+    constexpr void lookup_many(ForwardIt first, ForwardIt last, F&& on_found) const
+    {
+        std::size_t bindexes[details::lookup_batch_size];
+        node_index_type heads[details::lookup_batch_size];
+
+        while (first != last)
+        {
+            std::size_t count = 0;
+
+            for (auto it = first; it != last && count < details::lookup_batch_size; ++it)
+            {
+                ++count;
+            }
+
+            compute_bucket_indices(first, count, details::identity{}, bindexes);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                details::prefetch(&buckets_[bindexes[i]]);
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                heads[i] = buckets_[bindexes[i]];
+
+                if (heads[i] != node_end_index)
+                {
+                    details::prefetch(&nodes_[heads[i]]);
+                }
+            }
+
+            for (std::size_t i = 0; i < count; ++i, ++first)
+            {
+                auto index = heads[i];
+
+                while (index != node_end_index &&
+                       !key_equal_(nodes_[index].pair.const_key_pair().first, *first))
+                {
+                    index = nodes_[index].next;
+                }
+
+                on_found(index);
+            }
+        }
+    }
+
+    // Erases the node at position. Without back-links, what points to it is found by walking its
+    // chain.
+    constexpr auto erase_at(node_index_type position) -> iterator
+    {
+        std::size_t* previous_next = nullptr;
+
+        if constexpr (!has_back_links)
+        {
+            previous_next = find_previous_next_using_position(
+                nodes_[position].pair.const_key_pair().first, position);
+        }
+
+        return do_erase(previous_next, std::next(nodes_.begin(), position)).first;
+    }
+
+    constexpr auto
+    do_erase(std::size_t* previous_next, typename nodes_container_type::iterator sub_it)
+        -> std::pair<iterator, bool>
+    {
+        release_slot(*sub_it);
+
+        if constexpr (has_tombstones)
+        {
+            return {do_erase_tombstone(previous_next, sub_it), true};
+        }
+
+        if constexpr (has_back_links)
+        {
+            return do_erase_back_linked(sub_it);
+        }
+
+        // Skip the node by pointing the previous "next" to the one sub_it currently point to.
+        *previous_next = sub_it->next;
+
+        auto last = std::prev(nodes_.end());
+
+        // No need to do anything if the node was at the end of the vector.
+        if (sub_it == last)
+        {
+            nodes_.pop_back();
+            return {end(), true};
+        }
+
+        // Swap last node and the one we want to delete.
+        if constexpr (details::is_pair_trivially_relocatable_v<Key, T>)
+        {
+            details::bitwise_swap(*sub_it, *last);
+        }
+        else
+        {
+            using std::swap;
+            swap(*sub_it, *last);
+        }
+
+        // Now sub_it points to the one we swapped with. We have to readjust sub_it.
+        previous_next =
+            find_previous_next_using_position(sub_it->pair.pair().first, nodes_.size() - 1);
+        *previous_next = std::distance(nodes_.begin(), sub_it);
+        relocate_slot(*previous_next);
+
+        // Delete the last node forever and ever.
+        nodes_.pop_back();
+
+        return {iterator{sub_it, nodes_.end()}, true};
+    }
+
+    // Removes the nodes for which is_erased(node, index) is true, then relinks the kept ones.
+    template <class F>
+    auto erase_nodes_if(std::size_t thread_count, const F& is_erased) -> size_type
+    {
+        const auto count = nodes_.size();
+        const auto erased_count = remove_nodes_if(is_erased);
+
+        if (nodes_.size() != count)
+        {
+            if (thread_count > 1)
+            {
+                parallel_relink_nodes(thread_count);
+            }
+            else
+            {
+                relink_nodes();
+            }
+        }
+
+        return erased_count;
+    }
+
+    // Removes the dead nodes and the ones for which is_erased(node, index) is true, the latter
+    // being only called on live nodes, and returns how many live nodes were removed. The other
+    // nodes keep their order, and the buckets are left for the caller to rebuild.
+    template <class F>
+    auto remove_nodes_if(const F& is_erased) -> size_type
+    {
+        const auto is_removed = [this, &is_erased](stored_node_type& node, std::size_t index) {
+            if (node.is_dead())
+            {
+                return true;
+            }
+
+            if (!is_erased(node, index))
+            {
+                return false;
+            }
+
+            release_slot(node);
+            return true;
+        };
+
+        const auto count = nodes_.size();
+        size_type kept_count = 0;
+
+        while (kept_count < count && !is_removed(nodes_[kept_count], kept_count))
+        {
+            ++kept_count;
+        }
+
+        if (kept_count == count)
+        {
+            return 0u;
+        }
+
+        for (auto i = kept_count + 1; i < count; ++i)
+        {
+            if (is_removed(nodes_[i], i))
+            {
+                continue;
+            }
+
+            // The erased nodes drift toward the back where they are destroyed.
+            if constexpr (details::is_pair_trivially_relocatable_v<Key, T>)
+            {
+                details::bitwise_swap(nodes_[kept_count], nodes_[i]);
+            }
+            else
+            {
+                using std::swap;
+                swap(nodes_[kept_count], nodes_[i]);
+            }
+
+            relocate_slot(kept_count);
+            ++kept_count;
+        }
+
+        while (nodes_.size() > kept_count)
+        {
+            nodes_.pop_back();
+        }
+
+        const auto erased_count = count - kept_count - dead_node_count();
+        reset_dead_node_count();
+
+        return erased_count;
+    }
+
+    // Unlinks the node and marks it dead. Even the last node stays in place, so that the end of the
+    // nodes, which the live iterators keep a copy of, does not move.
+    constexpr auto
+    do_erase_tombstone(std::size_t* previous_next, typename nodes_container_type::iterator sub_it)
+        -> iterator
+    {
+        auto& victim = *sub_it;
+
+        if constexpr (has_back_links)
+        {
+            link_to(victim) = victim.next;
+
+            if (victim.next != node_end_index)
+            {
+                nodes_[victim.next].back = victim.back;
+            }
+        }
+        else
+        {
+            *previous_next = victim.next;
+        }
+
+        victim.next = details::node_dead_index<Key, T>;
+        ++dead_nodes_.value;
+
+        while (dead_nodes_.prefix < nodes_.size() && nodes_[dead_nodes_.prefix].is_dead())
+        {
+            ++dead_nodes_.prefix;
+        }
+
+        return ++iterator{sub_it, nodes_.end()};
+    }
+
+    // The node moved into the hole is patched through its back-link and the one of its next node,
+    // without hashing its key.
+    constexpr auto do_erase_back_linked(typename nodes_container_type::iterator sub_it)
+        -> std::pair<iterator, bool>
+    {
+        const auto position = static_cast<node_index_type>(std::distance(nodes_.begin(), sub_it));
+        auto& victim = *sub_it;
+
+        link_to(victim) = victim.next;
+
+        if (victim.next != node_end_index)
+        {
+            nodes_[victim.next].back = victim.back;
+        }
+
+        const auto last = nodes_.size() - 1;
+
+        if (position == last)
+        {
+            nodes_.pop_back();
+            return {end(), true};
+        }
+
+        if constexpr (details::is_pair_trivially_relocatable_v<Key, T>)
+        {
+            details::bitwise_swap(victim, nodes_[last]);
+        }
+        else
+        {
+            victim = std::move(nodes_[last]);
+        }
+
+        link_to(victim) = position;
+        relocate_slot(position);
+
+        if (victim.next != node_end_index)
+        {
+            nodes_[victim.next].back = position;
+        }
+
+        nodes_.pop_back();
+
+        return {iterator{sub_it, nodes_.end()}, true};
+    }
+
+    constexpr auto find_previous_next_using_position(const key_type& key, std::size_t position)
+        -> std::size_t*
+    {
+        const std::size_t bindex = bucket_index(key);
+
+        auto previous_next = &buckets_[bindex];
+        while (*previous_next != position)
+        {
+            previous_next = &nodes_[*previous_next].next;
+        }
+
+        return previous_next;
+    }
+
+    // Computes the bucket indices of count consecutive keys. Hashing and reducing the hashes to
+    // indices are done in two tight loops which the compiler vectorizes for integral keys.
+    template <class It, class Projection>
+    constexpr void compute_bucket_indices(
+        It first, std::size_t count, Projection projection, std::size_t* out) const
+    {
+        for (std::size_t i = 0; i < count; ++i, ++first)
+        {
+            out[i] = hash_(projection(*first));
+        }
+
+        const auto bucket_count = buckets_.size();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = compute_index(out[i], bucket_count);
+        }
+    }
+
+    constexpr void do_rehash(size_type count, std::size_t thread_count)
+    {
+        count = std::max(minimum_capacity(), count);
+        count = std::max(count, static_cast<size_type>(size() / max_load_factor()));
+
+        count = compute_closest_capacity(count);
+
+        assert(count > 0 && "The computed rehash size must be greater than 0.");
+
+        if (count == buckets_.size())
+        {
+            return;
+        }
+
+        // The buckets are resized first, so that failing to allocate them leaves the nodes as they
+        // were.
+        const auto old_count = buckets_.size();
+        buckets_.resize(count);
+
+        // Growing a power of two bucket count keeps the nodes of an old bucket together in the
+        // buckets it maps to, as long as the nodes did not move.
+        auto splits_chains = std::is_same_v<GrowthPolicy, details::power_of_two_growth_policy> &&
+                             old_count > 0 && count > old_count;
+
+        if constexpr (has_tombstones)
+        {
+            const auto nodes_count = nodes_.size();
+            remove_nodes_if(
+                [](const stored_node_type& /*node*/, std::size_t /*index*/) { return false; });
+            splits_chains = splits_chains && nodes_.size() == nodes_count;
+        }
+
+        if (thread_count > 1)
+        {
+            if (splits_chains)
+            {
+                parallel_split_chains(old_count, thread_count);
+            }
+            else
+            {
+                parallel_relink_nodes(thread_count);
+            }
+        }
+        else
+        {
+            relink_nodes();
+        }
+    }
+
+    template <class F>
+    void for_each_node(parallel_policy policy, const F& f)
+    {
+        details::parallel_for_chunks(
+            details::resolve_thread_count(policy, nodes_.size()), nodes_.size(),
+            details::parallel_chunk_size, [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i)
+                {
+                    if (!nodes_[i].is_dead())
+                    {
+                        f(nodes_[i]);
+                    }
+                }
+            });
+    }
+
+    template <class F>
+    void for_each_node(parallel_policy policy, const F& f) const
+    {
+        details::parallel_for_chunks(
+            details::resolve_thread_count(policy, nodes_.size()), nodes_.size(),
+            details::parallel_chunk_size, [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i)
+                {
+                    if (!nodes_[i].is_dead())
+                    {
+                        f(nodes_[i]);
+                    }
+                }
+            });
+    }
+
+    // Rebuilds all the chains from scratch, the nodes being linked in order.
+    constexpr void relink_nodes()
+    {
+        std::fill(buckets_.begin(), buckets_.end(), node_end_index);
+
+        const auto node_key = [](const stored_node_type& node) -> const key_type& {
+            return node.pair.const_key_pair().first;
+        };
+
+        std::size_t bindexes[details::lookup_batch_size];
+        const auto nodes_count = nodes_.size();
+
+        for (node_index_type start = 0; start < nodes_count; start += details::lookup_batch_size)
+        {
+            const auto count = std::min(details::lookup_batch_size, nodes_count - start);
+            compute_bucket_indices(std::next(nodes_.begin(), start), count, node_key, bindexes);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                details::prefetch(&buckets_[bindexes[i]]);
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                link_as_head(bindexes[i], start + i);
+            }
+        }
+    }
+
+    // The size and the capacities of the map before a range insertion reserving room up front.
+    struct saved_reservation
+    {
+        size_type size;
+        size_type bucket_count;
+        size_type nodes_capacity;
+    };
+
+    auto save_reservation() const -> saved_reservation
+    {
+        return {size(), bucket_count(), nodes_.capacity()};
+    }
+
+    // Once count elements were inserted in a map sized up front for all of them, gives back the
+    // room they did not use if most of them were duplicates, so that n copies of a key do not leave
+    // room for n elements behind. The capacities never go below the ones from before.
+    void release_unused_reservation(const saved_reservation& before, size_type count)
+    {
+        if (size() * 2u >= before.size + count)
+        {
+            return;
+        }
+
+        rehash(before.bucket_count);
+
+        if (nodes_.capacity() > std::max(before.nodes_capacity, size()))
+        {
+            nodes_.shrink_to_fit();
+            nodes_.reserve(before.nodes_capacity);
+        }
+    }
+
+    // Unlike reserve, never shrinks the buckets.
+    constexpr void grow_for(size_type count, std::size_t thread_count = 1u)
+    {
+        compact_if_mostly_dead();
+
+        if (count > bucket_count() * max_load_factor())
+        {
+            do_rehash(std::ceil(count / max_load_factor()), thread_count);
+        }
+
+        nodes_.reserve(count);
+    }
+
+    constexpr void compact_if_mostly_dead()
+    {
+        if constexpr (has_tombstones)
+        {
+            if (dead_nodes_.value * 2u > nodes_.size())
+            {
+                compact();
+            }
+        }
+    }
+
+    // Same as above for an erasure, returning where the element at next ends up.
+    constexpr auto compact_if_mostly_dead(iterator next) -> iterator
+    {
+        if constexpr (has_tombstones)
+        {
+            if (dead_nodes_.value * 2u > nodes_.size())
+            {
+                const auto first_node = nodes_.begin();
+                const auto next_node = next.sub_iterator();
+                const auto dead_before = std::count_if(
+                    first_node, next_node, [](const auto& node) { return node.is_dead(); });
+                const auto next_index = std::distance(first_node, next_node) - dead_before;
+
+                compact();
+                return iterator_at(next_index);
+            }
+        }
+
+        return next;
+    }
+
+    constexpr auto dead_node_count() const noexcept -> size_type
+    {
+        if constexpr (has_tombstones)
+        {
+            return dead_nodes_.value;
+        }
+        else
+        {
+            return 0u;
+        }
+    }
+
+    constexpr void reset_dead_node_count() noexcept
+    {
+        if constexpr (has_tombstones)
+        {
+            dead_nodes_.value = 0u;
+            dead_nodes_.prefix = 0u;
+        }
+    }
+
+    // The index of the first node which is not dead.
+    constexpr auto dead_prefix() const noexcept -> size_type
+    {
+        if constexpr (has_tombstones)
+        {
+            return dead_nodes_.prefix;
+        }
+        else
+        {
+            return 0u;
+        }
+    }
+
+    constexpr auto iterator_at(std::size_t index) -> iterator
+    {
+        return iterator{std::next(nodes_.begin(), index), nodes_.end()};
+    }
+
+    constexpr auto iterator_at(std::size_t index) const -> const_iterator
+    {
+        return const_iterator{std::next(nodes_.begin(), index), nodes_.end()};
+    }
+
+    constexpr void check_for_rehash()
+    {
+        compact_if_mostly_dead();
+
+        if (size() + 1 > bucket_count() * max_load_factor())
+        {
+            rehash(bucket_count() * 2);
+        }
+    }
+
+    constexpr auto dispatch_emplace() -> std::pair<iterator, bool>
+    {
+        return do_emplace(key_type{});
+    }
+
+    template <class Key2, class T2>
+    constexpr auto dispatch_emplace(Key2&& key, T2&& t) -> std::pair<iterator, bool>
+    {
+        if constexpr (is_lookup_key_v<Key2>)
+        {
+            return do_emplace(key, std::forward<Key2>(key), std::forward<T2>(t));
+        }
+        else
+        {
+            key_type new_key{std::forward<Key2>(key)};
+            return do_emplace(new_key, std::move(new_key), std::forward<T2>(t));
+        }
+    }
+
+    template <class Pair>
+    constexpr auto dispatch_emplace(Pair&& p) -> std::pair<iterator, bool>
+    {
+        if constexpr (is_lookup_key_v<decltype(p.first)>)
+        {
+            return do_emplace(p.first, std::forward<Pair>(p));
+        }
+        else
+        {
+            key_type new_key{std::forward<Pair>(p).first};
+            return do_emplace(new_key, std::move(new_key), std::forward<Pair>(p).second);
+        }
+    }
+
+    // Only the key is looked at before the lookup, the value being constructed in place on a miss.
+    template <class... Args1, class... Args2>
+    constexpr auto dispatch_emplace(
+        std::piecewise_construct_t, std::tuple<Args1...> first_args,
+        std::tuple<Args2...> second_args) -> std::pair<iterator, bool>
+    {
+        if constexpr (sizeof...(Args1) == 1 && (is_lookup_key_v<Args1> && ...))
         {
-            return {it, it};
+            const auto& key = std::get<0>(first_args);
+            return do_emplace(
+                key, std::piecewise_construct, std::move(first_args), std::move(second_args));
+        }
+        else
+        {
+            key_type key = std::make_from_tuple<key_type>(std::move(first_args));
+            return do_emplace(
+                key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                std::move(second_args));
         }
-
-        return {it, std::next(it)};
     }
 
-    constexpr auto begin(size_type n) -> local_iterator
+    template <class K, class... Args>
+    constexpr auto do_emplace(const K& key, Args&&... args) -> std::pair<iterator, bool>
     {
-        return local_iterator{buckets_[n], nodes_};
+        return do_emplace_hashed(hash_(key), key, std::forward<Args>(args)...);
     }
 
-    constexpr auto begin(size_type n) const -> const_local_iterator
+    template <class K, class... Args>
+    constexpr auto do_emplace_hashed(std::size_t hash, const K& key, Args&&... args)
+        -> std::pair<iterator, bool>
     {
-        return const_local_iterator{buckets_[n], nodes_};
+        const auto ignore = [](T& /*mapped*/) {};
+        return emplace_or_visit_hashed(hash, key, ignore, std::forward<Args>(args)...);
     }
 
-    constexpr auto cbegin(size_type n) const -> const_local_iterator
+    // A key already in the map is found before anything else happens, so that a hit neither
+    // constructs a node nor grows the map. visit(mapped) is then called instead.
+    template <class K, class Visit, class... Args>
+    constexpr auto
+    emplace_or_visit_hashed(std::size_t hash, const K& key, Visit& visit, Args&&... args)
+        -> std::pair<iterator, bool>
     {
-        return const_local_iterator{buckets_[n], nodes_};
-    }
+        const auto local_it = find_in_bucket(key, compute_index(hash, buckets_.size()));
 
-    constexpr auto end(size_type /*n*/) -> local_iterator { return local_iterator{nodes_}; }
+        if (local_it != end(0u))
+        {
+            const auto it = details::bucket_iterator_to_iterator(local_it, nodes_);
+            visit(it->second);
+            return {it, false};
+        }
 
-    constexpr auto end(size_type /*n*/) const -> const_local_iterator
-    {
-        return const_local_iterator{nodes_};
+        if constexpr (has_tombstones)
+        {
+            // Compacting or rehashing moves the nodes, which args may refer to, so the node is
+            // constructed first.
+            emplace_node(std::forward<Args>(args)...);
+            link_last_node(hash);
+        }
+        else
+        {
+            check_for_rehash();
+            append_in_bucket(compute_index(hash, buckets_.size()), std::forward<Args>(args)...);
+        }
+
+        return {iterator_at(nodes_.size() - 1), true};
     }
 
-    constexpr auto cend(size_type /*n*/) const -> const_local_iterator
+    // Links the unlinked node at the back. Growing the buckets or compacting the mostly dead nodes
+    // instead relinks every node, the last one included, which stays last. Should growing the
+    // buckets fail, the node is destroyed and the map is left as it was.
+    void link_last_node(std::size_t hash)
     {
-        return const_local_iterator{nodes_};
+        if (size() > bucket_count() * max_load_factor())
+        {
+#ifdef JG_NO_EXCEPTION
+            rehash(bucket_count() * 2);
+#else
+            try
+            {
+                rehash(bucket_count() * 2);
+            }
+            catch (...)
+            {
+                release_slot(nodes_.back());
+                nodes_.pop_back();
+                throw;
+            }
+#endif
+        }
+        else if (dead_node_count() * 2u > nodes_.size())
+        {
+            compact();
+        }
+        else
+        {
+            link_as_head(compute_index(hash, buckets_.size()), nodes_.size() - 1);
+        }
     }
 
-    constexpr auto bucket_count() const -> size_type { return buckets_.size(); }
+    template <class K, class V, class Combine>
+    auto upsert_hashed(std::size_t hash, K&& key, V&& value, Combine& combine)
+        -> std::pair<iterator, bool>
+    {
+        auto combine_into = [&combine, &value](T& mapped) {
+            if constexpr (std::is_void_v<std::invoke_result_t<Combine&, T&, V&&>>)
+            {
+                combine(mapped, std::forward<V>(value));
+            }
+            else
+            {
+                mapped = combine(mapped, std::forward<V>(value));
+            }
+        };
 
-    constexpr auto max_bucket_count() const -> size_type { return buckets_.max_size(); }
+        return emplace_or_visit_hashed(
+            hash, key, combine_into, std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<V>(value)));
+    }
 
-    constexpr auto bucket_size(size_type n) const -> size_type
+    // Inserts count pairs for which room has already been reserved.
+    template <bool uniqueKeys = false, class ForwardIt>
+    constexpr void insert_reserved(ForwardIt first, size_type count)
     {
-        return static_cast<size_t>(std::distance(begin(n), end(n)));
-    }
+        if constexpr (details::is_random_access_iterator_v<ForwardIt> && !keeps_insertion_order)
+        {
+            if (count >= details::radix_build_threshold)
+            {
+                insert_radix_partitioned<uniqueKeys>(first, count);
+                return;
+            }
+        }
 
-    constexpr auto bucket(const key_type& key) const -> size_type { return bucket_index(key); }
+        const auto pair_key = [](const auto& pair) -> const key_type& { return pair.first; };
 
-    constexpr auto load_factor() const -> float
-    {
-        return size() / static_cast<float>(bucket_count());
-    }
+        std::size_t bindexes[details::lookup_batch_size];
 
-    constexpr auto max_load_factor() const -> float { return max_load_factor_; }
+        while (count > 0)
+        {
+            const auto batch_count = std::min(details::lookup_batch_size, count);
+            compute_bucket_indices(first, batch_count, pair_key, bindexes);
 
-    constexpr void max_load_factor(float ml)
-    {
-        assert(ml > 0.0f && "The max load factor must be greater than 0.0f.");
-        max_load_factor_ = ml;
-        rehash(8);
+            for (std::size_t i = 0; i < batch_count; ++i, ++first)
+            {
+                auto&& pair = *first;
+
+                if constexpr (uniqueKeys)
+                {
+                    assert(find_in_bucket(pair.first, bindexes[i]) == end(0u) && "Duplicated key.");
+                    append_in_bucket(bindexes[i], std::forward<decltype(pair)>(pair));
+                }
+                else
+                {
+                    do_emplace_in_bucket(
+                        bindexes[i], pair.first, std::forward<decltype(pair)>(pair));
+                }
+            }
+
+            count -= batch_count;
+        }
     }
 
-    constexpr void rehash(size_type count)
-    {
-        count = std::max(minimum_capacity(), count);
-        count = std::max(count, static_cast<size_type>(size() / max_load_factor()));
+    template <class InputIt>
+    static inline constexpr bool is_parallel_buildable_v =
+        details::is_random_access_iterator_v<InputIt> &&
+        std::is_same_v<details::detected_t<details::iter_key_t, InputIt>, key_type>;
+
+    using positions_container_type = std::vector<
+        details::bucketed_position, details::rebind_alloc<Allocator, details::bucketed_position>>;
+    using counts_container_type =
+        std::vector<std::size_t, details::rebind_alloc<Allocator, std::size_t>>;
+
+    // The positions of count elements grouped by ranges of buckets. Within a partition, the
+    // positions keep the order of the elements.
+    struct bucket_partitions
+    {
+        positions_container_type positions;
+        counts_container_type begins;
+        std::size_t count;
+        std::size_t width;
+    };
 
-        count = compute_closest_capacity(count);
+    // Every thread hashes a slice of the elements and counts the elements of each partition, then
+    // scatters their positions into the partitions. This takes 24 bytes of scratch per element at
+    // its peak: the bucket indices, released on return, and the partitioned positions.
+    template <class RandomIt, class Projection>
+    auto partition_by_bucket(
+        std::size_t thread_count, RandomIt first, size_type count, Projection projection) const
+        -> bucket_partitions
+    {
+        // A few partitions per thread even out the work when the keys are skewed.
+        const auto partition_width =
+            std::max<std::size_t>(1u, bucket_count() / (thread_count * 4u));
+        const auto partition_count = (bucket_count() + partition_width - 1) / partition_width;
+
+        // The position of an element is its index in the slice, so only its bucket index is kept.
+        counts_container_type entries(count, get_allocator());
+        counts_container_type offsets(thread_count * partition_count, 0u, get_allocator());
+
+        details::run_workers(thread_count, [&](std::size_t worker) {
+            const auto [begin, end] = details::worker_slice(worker, thread_count, count);
+            auto* worker_counts = &offsets[worker * partition_count];
+            std::size_t bindexes[details::lookup_batch_size];
+
+            for (auto start = begin; start < end; start += details::lookup_batch_size)
+            {
+                const auto batch_count = std::min(details::lookup_batch_size, end - start);
+                compute_bucket_indices(
+                    std::next(first, start), batch_count, projection, bindexes);
+
+                for (std::size_t i = 0; i < batch_count; ++i)
+                {
+                    entries[start + i] = bindexes[i];
+                    ++worker_counts[bindexes[i] / partition_width];
+                }
+            }
+        });
 
-        assert(count > 0 && "The computed rehash size must be greater than 0.");
+        // Turns the counts into scatter offsets: partitions first, then threads in order.
+        bucket_partitions partitions{
+            positions_container_type(count, get_allocator()),
+            counts_container_type(partition_count + 1, 0u, get_allocator()), partition_count,
+            partition_width};
+        std::size_t offset = 0;
 
-        if (count == buckets_.size())
+        for (std::size_t partition = 0; partition < partition_count; ++partition)
         {
-            return;
-        }
+            partitions.begins[partition] = offset;
 
-        buckets_.resize(count);
+            for (std::size_t worker = 0; worker < thread_count; ++worker)
+            {
+                offset += std::exchange(offsets[worker * partition_count + partition], offset);
+            }
+        }
 
-        std::fill(buckets_.begin(), buckets_.end(), node_end_index);
+        partitions.begins[partition_count] = offset;
 
-        node_index_type index{0u};
+        details::run_workers(thread_count, [&](std::size_t worker) {
+            const auto [begin, end] = details::worker_slice(worker, thread_count, count);
+            auto* worker_offsets = &offsets[worker * partition_count];
 
-        for (auto& entry : nodes_)
+            for (auto i = begin; i < end; ++i)
+            {
+                const auto partition = entries[i] / partition_width;
+                partitions.positions[worker_offsets[partition]++] = {entries[i], i};
+            }
+        });
+
+        return partitions;
+    }
+
+    // Same as relink_nodes, each thread resetting and linking the buckets of its partitions.
+    void parallel_relink_nodes(std::size_t thread_count)
+    {
+        const auto node_key = [](const stored_node_type& node) -> const key_type& {
+            return node.pair.const_key_pair().first;
+        };
+
+        const auto partitions =
+            partition_by_bucket(thread_count, nodes_.begin(), nodes_.size(), node_key);
+
+        details::parallel_for_chunks(
+            thread_count, partitions.count, 1u, [&](auto begin, auto end) {
+                for (auto partition = begin; partition < end; ++partition)
+                {
+                    const auto buckets_first = partition * partitions.width;
+                    const auto buckets_last =
+                        std::min(buckets_first + partitions.width, bucket_count());
+                    std::fill(
+                        std::next(buckets_.begin(), buckets_first),
+                        std::next(buckets_.begin(), buckets_last), node_end_index);
+
+                    link_positions(
+                        partitions.positions, partitions.begins[partition],
+                        partitions.begins[partition + 1]);
+                }
+            });
+    }
+
+    // Same as relink_nodes once a power of two bucket count grew from old_count, without any
+    // scratch memory. The nodes of the old bucket b only go to the buckets b + k * old_count, so
+    // each thread owns a range of old buckets and splits their chains in place. The split chains
+    // keep the order of the old ones.
+    void parallel_split_chains(std::size_t old_count, std::size_t thread_count)
+    {
+        const auto new_count = buckets_.size();
+
+        details::parallel_for_chunks(
+            thread_count, old_count, details::parallel_chunk_size, [&](auto begin, auto end) {
+                for (auto bindex = begin; bindex < end; ++bindex)
+                {
+                    // Reversed first, so that linking its nodes as heads restores their order.
+                    auto reversed = node_end_index;
+                    for (auto index = buckets_[bindex]; index != node_end_index;)
+                    {
+                        const auto next = std::exchange(nodes_[index].next, reversed);
+                        reversed = index;
+                        index = next;
+                    }
+
+                    for (auto split = bindex; split < new_count; split += old_count)
+                    {
+                        buckets_[split] = node_end_index;
+                    }
+
+                    while (reversed != node_end_index)
+                    {
+                        const auto next = nodes_[reversed].next;
+                        const auto& key = nodes_[reversed].pair.const_key_pair().first;
+                        link_as_head(compute_index(hash_(key), new_count), reversed);
+                        reversed = next;
+                    }
+                }
+            });
+    }
+
+    // Links the nodes of positions[first, last) in order, the last one becoming the bucket head.
+    void link_positions(
+        const positions_container_type& positions, std::size_t first, std::size_t last)
+    {
+        for (auto i = first; i < last; ++i)
         {
-            entry.next = node_end_index;
-            reinsert_entry(entry, index);
-            index++;
+            link_as_head(positions[i].bindex, positions[i].position);
         }
     }
 
-    constexpr void reserve(std::size_t count)
+    template <bool uniqueKeys, class RandomIt>
+    void parallel_insert(parallel_policy policy, RandomIt first, size_type count)
     {
-        rehash(std::ceil(count / max_load_factor()));
-        nodes_.reserve(count);
-    }
+        const auto thread_count = details::resolve_thread_count(policy, count);
+        grow_for(size() + count, thread_count);
 
-    constexpr auto hash_function() const -> hasher { return hash_; }
+        if (thread_count <= 1)
+        {
+            insert_reserved<uniqueKeys>(first, count);
+            return;
+        }
 
-    constexpr auto key_eq() const -> key_equal { return key_equal_; }
+        const auto pair_key = [](const auto& pair) -> const key_type& { return pair.first; };
+
+        auto partitions = partition_by_bucket(thread_count, first, count, pair_key);
+        auto& positions = partitions.positions;
+
+        // Every partition is sorted by bucket and rid of the keys already seen, the first
+        // occurrence of a key winning. The existing nodes are only read at this point.
+        counts_container_type kept_ends(partitions.count, 0u, get_allocator());
+
+        details::parallel_for_chunks(
+            thread_count, partitions.count, 1u, [&](auto begin, auto end) {
+                for (auto partition = begin; partition < end; ++partition)
+                {
+                    const auto partition_first =
+                        std::next(positions.begin(), partitions.begins[partition]);
+                    const auto partition_last =
+                        std::next(positions.begin(), partitions.begins[partition + 1]);
+
+                    std::stable_sort(
+                        partition_first, partition_last,
+                        [](const auto& lhs, const auto& rhs) { return lhs.bindex < rhs.bindex; });
+
+                    if constexpr (uniqueKeys)
+                    {
+                        kept_ends[partition] = partitions.begins[partition + 1];
+                    }
+                    else
+                    {
+                        const auto kept_count =
+                            drop_duplicates(first, partition_first, partition_last);
+                        kept_ends[partition] = partitions.begins[partition] + kept_count;
+                    }
+                }
+            });
+
+        // The nodes are constructed in bucket order by this thread only, the positions now
+        // referring to them.
+        for (std::size_t partition = 0; partition < partitions.count; ++partition)
+        {
+            for (auto i = partitions.begins[partition]; i < kept_ends[partition]; ++i)
+            {
+                emplace_node(first[positions[i].position]);
+                positions[i].position = nodes_.size() - 1;
+            }
+        }
 
-private:
-    template <class K>
-    constexpr auto bucket_index(const K& key) const -> size_type
-    {
-        return compute_index(hash_(key), buckets_.size());
+        // The partitions cover disjoint bucket ranges, so their chains are linked concurrently.
+        details::parallel_for_chunks(
+            thread_count, partitions.count, 1u, [&](auto begin, auto end) {
+                for (auto partition = begin; partition < end; ++partition)
+                {
+                    link_positions(positions, partitions.begins[partition], kept_ends[partition]);
+                }
+            });
     }
 
-    template <class K>
-    constexpr auto find_in_bucket(const K& key, std::size_t bucket_index) -> local_iterator
+    // Moves the elements of [first, last) whose key is not in the map nor earlier in the range to
+    // the front of the range, keeping their order. The range is sorted by bucket index.
+    template <class RandomIt, class PositionsIt>
+    auto drop_duplicates(RandomIt input, PositionsIt first, PositionsIt last) const -> std::size_t
     {
-        auto b = begin(bucket_index);
-        auto e = end(0u);
-        auto it = std::find_if(b, e, [&key, this](auto& p) { return key_equal_(p.first, key); });
-        return it;
-    }
+        auto kept_last = first;
 
-    template <class K>
-    constexpr auto find_in_bucket(const K& key, std::size_t bucket_index) const
-        -> const_local_iterator
-    {
-        auto b = begin(bucket_index);
-        auto e = end(0u);
-        auto it = std::find_if(b, e, [&key, this](auto& p) { return key_equal_(p.first, key); });
-        return it;
+        for (auto run_first = first; run_first != last;)
+        {
+            const auto bindex = run_first->bindex;
+            const auto run_kept_first = kept_last;
+
+            for (; run_first != last && run_first->bindex == bindex; ++run_first)
+            {
+                const auto& key = input[run_first->position].first;
+
+                if (find_in_bucket(key, bindex) != end(0u) ||
+                    std::any_of(run_kept_first, kept_last, [&](const auto& kept) {
+                        return key_equal_(input[kept.position].first, key);
+                    }))
+                {
+                    continue;
+                }
+
+                *kept_last++ = *run_first;
+            }
+        }
+
+        return static_cast<std::size_t>(kept_last - first);
     }
 
-    constexpr auto
-    do_erase(std::size_t* previous_next, typename nodes_container_type::iterator sub_it)
-        -> std::pair<iterator, bool>
+    // Large ranges are sorted by bucket index before being inserted. The buckets are then written
+    // in order, and the nodes of a chain end up next to each other which keeps lookups local.
+    template <bool uniqueKeys, class RandomIt>
+    void insert_radix_partitioned(RandomIt first, size_type count)
     {
-        // Skip the node by pointing the previous "next" to the one sub_it currently point to.
-        *previous_next = sub_it->next;
+        const auto pair_key = [](const auto& pair) -> const key_type& { return pair.first; };
 
-        auto last = std::prev(nodes_.end());
+        positions_container_type entries(count, get_allocator());
+        std::size_t bindexes[details::lookup_batch_size];
 
-        // No need to do anything if the node was at the end of the vector.
-        if (sub_it == last)
+        for (size_type start = 0; start < count; start += details::lookup_batch_size)
         {
-            nodes_.pop_back();
-            return {end(), true};
+            const auto batch_count = std::min(details::lookup_batch_size, count - start);
+            compute_bucket_indices(std::next(first, start), batch_count, pair_key, bindexes);
+
+            for (std::size_t i = 0; i < batch_count; ++i)
+            {
+                entries[start + i] = {bindexes[i], start + i};
+            }
         }
 
-        // Swap last node and the one we want to delete.
-        using std::swap;
-        swap(*sub_it, *last);
+        {
+            positions_container_type scratch(get_allocator());
+            details::radix_sort_by_bucket(entries, scratch, bucket_count());
+        }
 
-        // Now sub_it points to the one we swapped with. We have to readjust sub_it.
-        previous_next =
-            find_previous_next_using_position(sub_it->pair.pair().first, nodes_.size() - 1);
-        *previous_next = std::distance(nodes_.begin(), sub_it);
+        constexpr size_type prefetch_distance = 8u;
 
-        // Delete the last node forever and ever.
-        nodes_.pop_back();
+        for (size_type i = 0; i < count; ++i)
+        {
+            if (i + prefetch_distance < count)
+            {
+                const auto& upcoming = first[entries[i + prefetch_distance].position];
+                details::prefetch(std::addressof(upcoming));
+            }
+
+            auto&& pair = first[entries[i].position];
 
-        return {iterator{sub_it}, true};
+            if constexpr (uniqueKeys)
+            {
+                assert(
+                    find_in_bucket(pair.first, entries[i].bindex) == end(0u) && "Duplicated key.");
+                append_in_bucket(entries[i].bindex, std::forward<decltype(pair)>(pair));
+            }
+            else
+            {
+                do_emplace_in_bucket(
+                    entries[i].bindex, pair.first, std::forward<decltype(pair)>(pair));
+            }
+        }
     }
 
-    constexpr auto find_previous_next_using_position(const key_type& key, std::size_t position)
-        -> std::size_t*
+    template <class... Args>
+    constexpr auto do_emplace_in_bucket(std::size_t bindex, const key_type& key, Args&&... args)
+        -> std::pair<iterator, bool>
     {
-        const std::size_t bindex = bucket_index(key);
+        auto local_it = find_in_bucket(key, bindex);
 
-        auto previous_next = &buckets_[bindex];
-        while (*previous_next != position)
+        if (local_it != end(0u))
         {
-            previous_next = &nodes_[*previous_next].next;
+            return std::pair{details::bucket_iterator_to_iterator(local_it, nodes_), false};
         }
 
-        return previous_next;
-    }
+        append_in_bucket(bindex, std::forward<Args>(args)...);
 
-    constexpr void reinsert_entry(node_type& entry, node_index_type index)
-    {
-        const auto bindex = bucket_index(entry.pair.const_key_pair().first);
-        auto old_index = std::exchange(buckets_[bindex], index);
-        entry.next = old_index;
+        return std::pair{std::prev(end()), true};
     }
 
-    constexpr void check_for_rehash()
+    // Takes over all the nodes of source, this map being empty, and links them in its own buckets.
+    void splice_nodes(dense_hash_map& source)
     {
-        if (size() + 1 > bucket_count() * max_load_factor())
+        static_assert(!has_stable_handles, "The slots of source would clash with the stale ones.");
+
+        nodes_ = std::move(source.nodes_);
+        dead_nodes_ = std::move(source.dead_nodes_);
+        source.clear();
+
+        if constexpr (has_tombstones)
         {
-            rehash(bucket_count() * 2);
+            remove_nodes_if(
+                [](const stored_node_type& /*node*/, std::size_t /*index*/) { return false; });
         }
+
+        const auto needed = compute_closest_capacity(std::max(
+            minimum_capacity(), static_cast<size_type>(std::ceil(size() / max_load_factor()))));
+        buckets_.resize(std::max(needed, buckets_.size()));
+        relink_nodes();
     }
 
-    constexpr auto dispatch_emplace() -> std::pair<iterator, bool>
+    // Constructs a node at the back and makes it the head of the bucket.
+    template <class... Args>
+    constexpr void append_in_bucket(std::size_t bindex, Args&&... args)
     {
-        return do_emplace(key_type{});
+        emplace_node(std::forward<Args>(args)...);
+        link_as_head(bindex, nodes_.size() - 1);
     }
 
-    template <class Key2, class T2>
-    constexpr auto dispatch_emplace(Key2&& key, T2&& t) -> std::pair<iterator, bool>
+    // Constructs an unlinked node at the back, giving it a slot under stable handles. The slots
+    // store the node indices on 32 bits, which caps max_size().
+    template <class... Args>
+    constexpr void emplace_node(Args&&... args)
     {
-        if constexpr (std::is_same_v<std::decay_t<Key2>, key_type>)
+        if constexpr (has_stable_handles)
         {
-            return do_emplace(key, std::forward<Key2>(key), std::forward<T2>(t));
+            if (nodes_.size() >= max_size())
+            {
+#ifdef JG_NO_EXCEPTION
+                std::abort();
+#else
+                throw std::length_error("The stable handles cannot refer to more nodes.");
+#endif
+            }
+
+            slots_.prepare_acquire();
         }
-        else
+
+        nodes_.emplace_back(node_end_index, std::forward<Args>(args)...);
+
+        if constexpr (has_stable_handles)
         {
-            key_type new_key{std::forward<Key2>(key)};
-            // TODO: double check that I am allowed to optimized by sending new_key here and not key
-            // https://eel.is/c++draft/unord.req#lib:emplace,unordered_associative_containers
-            return do_emplace(new_key, std::move(new_key), std::forward<T2>(t));
+            nodes_.back().slot = slots_.acquire(nodes_.size() - 1);
         }
     }
 
-    template <class Pair>
-    constexpr auto dispatch_emplace(Pair&& p) -> std::pair<iterator, bool>
+    constexpr void release_slot(const stored_node_type& node) noexcept
     {
-        if constexpr (std::is_same_v<std::decay_t<decltype(p.first)>, key_type>)
+        if constexpr (has_stable_handles)
         {
-            return do_emplace(p.first, std::forward<Pair>(p));
+            slots_.release(node.slot);
         }
-        else
+    }
+
+    constexpr void relocate_slot(node_index_type index) noexcept
+    {
+        if constexpr (has_stable_handles)
         {
-            key_type new_key{std::forward<Pair>(p).first};
-            return do_emplace(new_key, std::move(new_key), std::forward<Pair>(p).second);
+            slots_.relocate(nodes_[index].slot, index);
         }
     }
 
-    template <class... Args1, class... Args2>
-    constexpr auto dispatch_emplace(
-        std::piecewise_construct_t, std::tuple<Args1...> first_args,
-        std::tuple<Args2...> second_args) -> std::pair<iterator, bool>
+    constexpr void release_all_slots() noexcept
     {
-        std::pair<Key, T> p{std::piecewise_construct, std::move(first_args),
-                            std::move(second_args)};
-        return dispatch_emplace(std::move(p));
+        if constexpr (has_stable_handles)
+        {
+            slots_.release_all();
+        }
     }
 
-    template <class... Args>
-    constexpr auto do_emplace(const key_type& key, Args&&... args) -> std::pair<iterator, bool>
+    constexpr void link_as_head(std::size_t bindex, node_index_type index)
     {
-        check_for_rehash();
+        auto& node = nodes_[index];
+        node.next = std::exchange(buckets_[bindex], index);
 
-        const auto bindex = bucket_index(key);
-        auto local_it = find_in_bucket(key, bindex);
-
-        if (local_it != end(0u))
+        if constexpr (has_back_links)
         {
-            return std::pair{details::bucket_iterator_to_iterator(local_it, nodes_), false};
+            node.back = bindex | details::back_link_to_bucket;
+
+            if (node.next != node_end_index)
+            {
+                nodes_[node.next].back = index;
+            }
         }
+    }
 
-        nodes_.emplace_back(buckets_[bindex], std::forward<Args>(args)...);
-        buckets_[bindex] = nodes_.size() - 1;
+    // The bucket or the next member pointing to the node, found through its back-link.
+    constexpr auto link_to(const stored_node_type& node) -> node_index_type&
+    {
+        if (node.back & details::back_link_to_bucket)
+        {
+            return buckets_[node.back & ~details::back_link_to_bucket];
+        }
 
-        return std::pair{std::prev(end()), true};
+        return nodes_[node.back].next;
     }
 
     hasher hash_;
@@ -891,12 +2926,22 @@ private:
     buckets_container_type buckets_;
     nodes_container_type nodes_;
     float max_load_factor_ = details::default_max_load_factor;
+    std::conditional_t<has_tombstones, details::tombstone_count, details::no_tombstone_count>
+        dead_nodes_;
+    std::conditional_t<
+        has_stable_handles, details::slot_table<Allocator>, details::no_slot_table>
+        slots_;
 };
 
-template <class Key, class T, class Hash, class KeyEqual, class Allocator>
+template <
+    class Key, class T, class Hash, class KeyEqual, class Allocator, class GrowthPolicy,
+    class NodesContainerPolicy, class ErasePolicy>
 constexpr auto operator==(
-    const dense_hash_map<Key, T, Hash, KeyEqual, Allocator>& lhs,
-    const dense_hash_map<Key, T, Hash, KeyEqual, Allocator>& rhs) -> bool
+    const dense_hash_map<
+        Key, T, Hash, KeyEqual, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& lhs,
+    const dense_hash_map<
+        Key, T, Hash, KeyEqual, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& rhs)
+    -> bool
 {
     if (lhs.size() != rhs.size())
     {
@@ -916,10 +2961,15 @@ constexpr auto operator==(
     return true;
 }
 
-template <class Key, class T, class Hash, class KeyEqual, class Allocator>
+template <
+    class Key, class T, class Hash, class KeyEqual, class Allocator, class GrowthPolicy,
+    class NodesContainerPolicy, class ErasePolicy>
 constexpr auto operator!=(
-    const dense_hash_map<Key, T, Hash, KeyEqual, Allocator>& lhs,
-    const dense_hash_map<Key, T, Hash, KeyEqual, Allocator>& rhs) -> bool
+    const dense_hash_map<
+        Key, T, Hash, KeyEqual, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& lhs,
+    const dense_hash_map<
+        Key, T, Hash, KeyEqual, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& rhs)
+    -> bool
 {
     return !(lhs == rhs);
 }
@@ -994,45 +3044,55 @@ template <
 dense_hash_map(std::initializer_list<std::pair<Key, T>>, details::node_index_t<Key, T>, Hash, Alloc)
     ->dense_hash_map<Key, T, Hash, std::equal_to<Key>, Alloc>;
 
+// A dense_hash_map iterating over its elements in the order they were inserted. Erasing leaves a
+// dead node behind, and the dead nodes are compacted away in bulk.
+template <
+    class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>,
+    class Allocator = std::allocator<std::pair<const Key, T>>,
+    class GrowthPolicy = details::power_of_two_growth_policy,
+    class NodesContainerPolicy = details::vector_nodes_container_policy>
+using ordered_dense_hash_map = dense_hash_map<
+    Key, T, Hash, Pred, Allocator, GrowthPolicy, NodesContainerPolicy,
+    details::insertion_order_erase_policy>;
+
 namespace pmr
 {
     template <
         class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>,
-        class GrowthPolicy = details::power_of_two_growth_policy>
+        class GrowthPolicy = details::power_of_two_growth_policy,
+        class NodesContainerPolicy = details::vector_nodes_container_policy,
+        class ErasePolicy = details::swap_with_last_erase_policy>
     using dense_hash_map = dense_hash_map<
-        Key, T, Hash, Pred, std::pmr::polymorphic_allocator<std::pair<const Key, T>>, GrowthPolicy>;
+        Key, T, Hash, Pred, std::pmr::polymorphic_allocator<std::pair<const Key, T>>, GrowthPolicy,
+        NodesContainerPolicy, ErasePolicy>;
 } // namespace pmr
 
 } // namespace jg
 
 namespace std
 {
-template <class Key, class T, class Hash, class Pred, class Allocator, class GrowthPolicy>
+template <
+    class Key, class T, class Hash, class Pred, class Allocator, class GrowthPolicy,
+    class NodesContainerPolicy, class ErasePolicy>
 constexpr void swap(
-    jg::dense_hash_map<Key, T, Hash, Pred, Allocator, GrowthPolicy>& lhs,
-    jg::dense_hash_map<Key, T, Hash, Pred, Allocator, GrowthPolicy>&
+    jg::dense_hash_map<
+        Key, T, Hash, Pred, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& lhs,
+    jg::dense_hash_map<
+        Key, T, Hash, Pred, Allocator, GrowthPolicy, NodesContainerPolicy, ErasePolicy>&
         rhs) noexcept(noexcept(lhs.swap(rhs)))
 {
     lhs.swap(rhs);
 }
 
-template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Pred>
-constexpr void erase_if(jg::dense_hash_map<Key, T, Hash, KeyEqual, Alloc>& c, Pred pred)
+template <
+    class Key, class T, class Hash, class KeyEqual, class Alloc, class GrowthPolicy,
+    class NodesContainerPolicy, class ErasePolicy, class Pred>
+constexpr void erase_if(
+    jg::dense_hash_map<
+        Key, T, Hash, KeyEqual, Alloc, GrowthPolicy, NodesContainerPolicy, ErasePolicy>& c,
+    Pred pred)
 {
-    auto rit = std::make_reverse_iterator(c.end());
-    auto rend = std::make_reverse_iterator(c.begin());
-
-    while (rit != rend)
-    {
-        if (pred(*rit))
-        {
-            rit = std::make_reverse_iterator(c.erase(std::prev(rit.base())));
-        }
-        else
-        {
-            ++rit;
-        }
-    }
+    c.erase_if(std::move(pred));
 }
 
 } // namespace std
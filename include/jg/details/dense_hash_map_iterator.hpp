@@ -9,8 +9,38 @@
 namespace jg::details
 {
 
+// The iterators of the maps keeping dead nodes skip them, and need to know where the nodes end.
+template <class SubIterator, bool skipDeadNodes>
+struct nodes_end_holder
+{
+    constexpr nodes_end_holder() noexcept = default;
+    constexpr explicit nodes_end_holder(const SubIterator& /*end*/) noexcept {}
+
+    template <class OtherSubIterator>
+    constexpr nodes_end_holder(const nodes_end_holder<OtherSubIterator, false>& /*other*/) noexcept
+    {}
+};
+
+template <class SubIterator>
+struct nodes_end_holder<SubIterator, true>
+{
+    constexpr nodes_end_holder() noexcept = default;
+    constexpr explicit nodes_end_holder(const SubIterator& end) noexcept : nodes_end_(end) {}
+
+    template <class OtherSubIterator>
+    constexpr nodes_end_holder(const nodes_end_holder<OtherSubIterator, true>& other) noexcept
+        : nodes_end_(other.nodes_end_)
+    {}
+
+    SubIterator nodes_end_{};
+};
+
 template <class Key, class T, class Container, bool isConst, bool projectToConstKey>
 class dense_hash_map_iterator
+    : private nodes_end_holder<
+          std::conditional_t<
+              isConst, typename Container::const_iterator, typename Container::iterator>,
+          Container::value_type::may_be_dead>
 {
     friend dense_hash_map_iterator<Key, T, Container, true, projectToConstKey>;
 
@@ -23,7 +53,14 @@ public:
     using projected_type =
         std::pair<typename std::conditional<projectToConstKey, const Key, Key>::type, T>;
 
-    using iterator_category = typename sub_iterator_type_traits::iterator_category;
+    static constexpr bool skip_dead_nodes = entries_container_type::value_type::may_be_dead;
+    using nodes_end_type = nodes_end_holder<sub_iterator_type, skip_dead_nodes>;
+
+    // Skipping the dead nodes leaves no constant time way to move by n elements, so the arithmetic
+    // operators are only available when no node is ever dead.
+    using iterator_category = std::conditional_t<
+        skip_dead_nodes, std::bidirectional_iterator_tag,
+        typename sub_iterator_type_traits::iterator_category>;
     using value_type = std::conditional_t<isConst, const projected_type, projected_type>;
     using difference_type = typename sub_iterator_type_traits::difference_type;
     using reference = value_type&;
@@ -31,10 +68,16 @@ public:
 
     constexpr dense_hash_map_iterator() noexcept : sub_iterator_(sub_iterator_type{}) {}
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     explicit constexpr dense_hash_map_iterator(sub_iterator_type it) noexcept
         : sub_iterator_(std::move(it))
     {}
 
+    // it must point to a live node or to end.
+    constexpr dense_hash_map_iterator(sub_iterator_type it, const sub_iterator_type& end) noexcept
+        : nodes_end_type(end), sub_iterator_(std::move(it))
+    {}
+
     constexpr dense_hash_map_iterator(const dense_hash_map_iterator& other) noexcept = default;
     constexpr dense_hash_map_iterator(dense_hash_map_iterator&& other) noexcept = default;
 
@@ -46,7 +89,7 @@ public:
     template <bool DepIsConst = isConst, std::enable_if_t<DepIsConst, int> = 0>
     constexpr dense_hash_map_iterator(
         const dense_hash_map_iterator<Key, T, Container, false, projectToConstKey>& other) noexcept
-        : sub_iterator_(other.sub_iterator_)
+        : nodes_end_type(other.nodes_end()), sub_iterator_(other.sub_iterator_)
     {}
 
     constexpr auto operator*() const noexcept -> reference
@@ -76,55 +119,95 @@ public:
     constexpr auto operator++() noexcept -> dense_hash_map_iterator&
     {
         ++sub_iterator_;
+
+        if constexpr (skip_dead_nodes)
+        {
+            while (sub_iterator_ != this->nodes_end_ && sub_iterator_->is_dead())
+            {
+                ++sub_iterator_;
+            }
+        }
+
         return *this;
     }
 
-    constexpr auto operator++(int) noexcept -> dense_hash_map_iterator { return {sub_iterator_++}; }
+    constexpr auto operator++(int) noexcept -> dense_hash_map_iterator
+    {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
 
+    // Going back from any iterator but the first one always reaches a live node.
     constexpr auto operator--() noexcept -> dense_hash_map_iterator&
     {
         --sub_iterator_;
+
+        if constexpr (skip_dead_nodes)
+        {
+            while (sub_iterator_->is_dead())
+            {
+                --sub_iterator_;
+            }
+        }
+
         return *this;
     }
 
-    constexpr auto operator--(int) noexcept -> dense_hash_map_iterator { return {sub_iterator_--}; }
+    constexpr auto operator--(int) noexcept -> dense_hash_map_iterator
+    {
+        auto copy = *this;
+        --*this;
+        return copy;
+    }
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     constexpr auto operator[](difference_type index) const noexcept -> reference
     {
         if constexpr (projectToConstKey)
         {
-            return sub_iterator_[index]->pair.const_key_pair();
+            return sub_iterator_[index].pair.const_key_pair();
         }
         else
         {
-            return sub_iterator_[index]->pair.pair();
+            return sub_iterator_[index].pair.pair();
         }
     }
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     constexpr auto operator+=(difference_type n) noexcept -> dense_hash_map_iterator&
     {
         sub_iterator_ += n;
         return *this;
     }
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     constexpr auto operator+(difference_type n) const noexcept -> dense_hash_map_iterator
     {
-        return {sub_iterator_ + n};
+        auto copy = *this;
+        copy.sub_iterator_ += n;
+        return copy;
     }
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     constexpr auto operator-=(difference_type n) noexcept -> dense_hash_map_iterator&
     {
         sub_iterator_ -= n;
         return *this;
     }
 
+    template <bool DepSkip = skip_dead_nodes, std::enable_if_t<!DepSkip, int> = 0>
     constexpr auto operator-(difference_type n) const noexcept -> dense_hash_map_iterator
     {
-        return {sub_iterator_ - n};
+        auto copy = *this;
+        copy.sub_iterator_ -= n;
+        return copy;
     }
 
     constexpr auto sub_iterator() const -> const sub_iterator_type& { return sub_iterator_; }
 
+    constexpr auto nodes_end() const -> const nodes_end_type& { return *this; }
+
 private:
     sub_iterator_type sub_iterator_;
 };
@@ -183,7 +266,9 @@ constexpr auto operator>=(
     return lhs.sub_iterator() >= rhs.sub_iterator();
 }
 
-template <class Key, class T, class Container, bool isConst, bool projectToConstKey, bool isConst2>
+template <
+    class Key, class T, class Container, bool isConst, bool projectToConstKey, bool isConst2,
+    std::enable_if_t<!Container::value_type::may_be_dead, int> = 0>
 constexpr auto operator-(
     const dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>& lhs,
     const dense_hash_map_iterator<Key, T, Container, isConst2, projectToConstKey>& rhs) noexcept ->
@@ -192,14 +277,16 @@ constexpr auto operator-(
     return lhs.sub_iterator() - rhs.sub_iterator();
 }
 
-template <class Key, class T, class Container, bool isConst, bool projectToConstKey>
+template <
+    class Key, class T, class Container, bool isConst, bool projectToConstKey,
+    std::enable_if_t<!Container::value_type::may_be_dead, int> = 0>
 constexpr auto operator+(
     typename dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>::difference_type
         n,
     const dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>& it) noexcept
     -> dense_hash_map_iterator<Key, T, Container, isConst, projectToConstKey>
 {
-    return {n + it.sub_iterator()};
+    return it + n;
 }
 
 } // namespace jg::details
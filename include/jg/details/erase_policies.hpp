@@ -0,0 +1,124 @@
+#ifndef JG_ERASE_POLICIES_HPP
+#define JG_ERASE_POLICIES_HPP
+
+#include "type_traits.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace jg::details
+{
+
+// An erase policy tells dense_hash_map how to fill the hole left in its nodes by an erased
+// element. It is a struct of static constexpr flags, the missing ones being false:
+// - back_links: every node remembers which bucket or node points to it. Moving the last node into
+//   the hole then needs neither hashing its key nor walking its chain, and the moved node is
+//   move-assigned rather than swapped.
+// - tombstones: the erased nodes are unlinked and marked dead but stay in place, so that erasing
+//   usually moves no node. Iterators and node indices then stay valid across erasures, other than
+//   the ones to the erased elements. The dead nodes are compacted away in bulk by compact(), by a
+//   rehash, or by the insertion or erasure which leaves more than half of the nodes dead. That
+//   erasure invalidates the iterators, but for the one it returns.
+// - stable_handles: every node owns a slot in an indirection table mapping stable_handle to node
+//   indices, which is patched whenever a node moves. Handles then survive the erasure of other
+//   elements and the rehashes. Each element costs a 4 bytes slot index in its node, often padded
+//   to 8, plus an 8 bytes entry in the table, and resolving a handle costs a table lookup.
+// - insertion_order: the elements are iterated in the order they were inserted. This requires
+//   tombstones, and makes the bulk insertions append the elements in the order of their range
+//   rather than sorting them by bucket.
+
+// Moves the last node into the hole, finding what points to it by walking its chain.
+struct swap_with_last_erase_policy
+{
+};
+
+// Moves the last node into the hole, patching what points to it through its back-link.
+struct back_link_erase_policy
+{
+    static constexpr bool back_links = true;
+};
+
+// Leaves dead nodes behind which are compacted away later.
+struct tombstone_erase_policy
+{
+    static constexpr bool tombstones = true;
+};
+
+// Moves the last node into the hole like swap_with_last_erase_policy, keeping the handles valid.
+struct stable_handle_erase_policy
+{
+    static constexpr bool stable_handles = true;
+};
+
+// Leaves dead nodes behind and keeps the elements in insertion order, like Python's dict.
+struct insertion_order_erase_policy
+{
+    static constexpr bool tombstones = true;
+    static constexpr bool insertion_order = true;
+};
+
+template <class Policy>
+using detect_back_links = std::bool_constant<Policy::back_links>;
+
+template <class Policy>
+inline constexpr bool has_back_links_v =
+    detected_or<std::false_type, detect_back_links, Policy>::type::value;
+
+template <class Policy>
+using detect_tombstones = std::bool_constant<Policy::tombstones>;
+
+template <class Policy>
+inline constexpr bool has_tombstones_v =
+    detected_or<std::false_type, detect_tombstones, Policy>::type::value;
+
+template <class Policy>
+using detect_stable_handles = std::bool_constant<Policy::stable_handles>;
+
+template <class Policy>
+inline constexpr bool has_stable_handles_v =
+    detected_or<std::false_type, detect_stable_handles, Policy>::type::value;
+
+template <class Policy>
+using detect_insertion_order = std::bool_constant<Policy::insertion_order>;
+
+template <class Policy>
+inline constexpr bool has_insertion_order_v =
+    detected_or<std::false_type, detect_insertion_order, Policy>::type::value;
+
+// The amount of dead nodes, and how many of them come before the first live one so that begin()
+// does not walk them. Both are reset when moved from, just like the moved nodes container.
+class tombstone_count
+{
+public:
+    constexpr tombstone_count() noexcept = default;
+    constexpr tombstone_count(const tombstone_count& other) noexcept = default;
+    constexpr tombstone_count(tombstone_count&& other) noexcept
+        : value(other.value), prefix(other.prefix)
+    {
+        other.value = 0u;
+        other.prefix = 0u;
+    }
+
+    constexpr auto operator=(const tombstone_count& other) noexcept -> tombstone_count& = default;
+    constexpr auto operator=(tombstone_count&& other) noexcept -> tombstone_count&
+    {
+        value = other.value;
+        prefix = other.prefix;
+        other.value = 0u;
+        other.prefix = 0u;
+        return *this;
+    }
+
+    std::size_t value = 0;
+    std::size_t prefix = 0;
+};
+
+// Takes the place of tombstone_count in the maps without tombstones.
+struct no_tombstone_count
+{
+};
+
+} // namespace jg::details
+
+#endif // JG_ERASE_POLICIES_HPP
@@ -1,6 +1,11 @@
 #ifndef JG_NODE_HPP
 #define JG_NODE_HPP
 
+#include "erase_policies.hpp"
+#include "type_traits.hpp"
+
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <type_traits>
@@ -10,7 +15,9 @@
 namespace jg::details
 {
 
-template <class Key, class T, class Pair = std::pair<Key, T>>
+template <
+    class Key, class T, class Pair = std::pair<Key, T>,
+    class ErasePolicy = swap_with_last_erase_policy>
 struct node;
 
 template <class Key, class T>
@@ -19,6 +26,10 @@ using node_index_t = typename std::vector<node<Key, T>>::size_type;
 template <class Key, class T>
 constexpr node_index_t<Key, T> node_end_index = std::numeric_limits<node_index_t<Key, T>>::max();
 
+// Stored in the next member of the nodes erased under a tombstone erase policy.
+template <class Key, class T>
+constexpr node_index_t<Key, T> node_dead_index = node_end_index<Key, T> - 1;
+
 template <class Key, class T>
 union union_key_value_pair
 {
@@ -199,12 +210,48 @@ struct disable_move_assignment<T, true>
 {
 };
 
-template <class Key, class T, class Pair>
+// Per node bookkeeping required by some erase policies. The nodes inherit from it so that it takes
+// no room when unused.
+template <bool hasBackLink>
+struct node_links
+{
+};
+
+template <>
+struct node_links<true>
+{
+    // Index of the node pointing to this one, or of its bucket with back_link_to_bucket set.
+    std::size_t back = 0;
+};
+
+template <bool hasSlot>
+struct node_slot
+{
+};
+
+template <>
+struct node_slot<true>
+{
+    // Index of the slot of this node in the stable handles table.
+    std::uint32_t slot = 0;
+};
+
+static constexpr const std::size_t back_link_to_bucket =
+    ~(std::numeric_limits<std::size_t>::max() >> 1);
+
+template <class Key, class T, class Pair, class ErasePolicy>
 struct node : disable_copy_constructor<Pair>,
               disable_copy_assignment<Pair>,
               disable_move_constructor<Pair>,
-              disable_move_assignment<Pair>
+              disable_move_assignment<Pair>,
+              node_links<has_back_links_v<ErasePolicy>>,
+              node_slot<has_stable_handles_v<ErasePolicy>>
 {
+    using links_type = node_links<has_back_links_v<ErasePolicy>>;
+    using slot_type = node_slot<has_stable_handles_v<ErasePolicy>>;
+
+    static constexpr bool may_be_dead = has_tombstones_v<ErasePolicy>;
+
     template <class... Args>
     constexpr node(node_index_t<Key, T> next, Args&&... args)
         : next(next), pair(std::forward<Args>(args)...)
@@ -218,24 +265,81 @@ struct node : disable_copy_constructor<Pair>,
 
     template <class Allocator, class Node>
     constexpr node(std::allocator_arg_t, const Allocator& alloc, const Node& other)
-        : next(other.next), pair(std::allocator_arg, alloc, other.pair.pair())
+        : links_type(other)
+        , slot_type(other)
+        , next(other.next)
+        , pair(std::allocator_arg, alloc, other.pair.pair())
     {}
 
     template <class Allocator, class Node>
     constexpr node(std::allocator_arg_t, const Allocator& alloc, Node&& other)
-        : next(std::move(other.next)), pair(std::allocator_arg, alloc, std::move(other.pair.pair()))
+        : links_type(other)
+        , slot_type(other)
+        , next(std::move(other.next))
+        , pair(std::allocator_arg, alloc, std::move(other.pair.pair()))
     {}
 
     node_index_t<Key, T> next = node_end_index<Key, T>;
     key_value_pair_t<Key, T> pair;
+
+    constexpr auto is_dead() const noexcept -> bool
+    {
+        return may_be_dead && next == node_dead_index<Key, T>;
+    }
+};
+
+template <class Key, class T>
+inline constexpr bool is_pair_bitwise_copyable_v =
+    std::is_trivially_copy_constructible_v<Key>&& std::is_trivially_destructible_v<Key>&&
+        std::is_trivially_copy_constructible_v<T>&& std::is_trivially_destructible_v<T>;
+
+template <class Key, class T>
+inline constexpr bool is_pair_trivially_relocatable_v =
+    is_pair_bitwise_copyable_v<Key, T> ||
+    (jg::is_trivially_relocatable_v<Key> && jg::is_trivially_relocatable_v<T>);
+
+template <class Key, class T, class Pair, class ErasePolicy>
+struct is_bitwise_copyable<node<Key, T, Pair, ErasePolicy>>
+    : std::bool_constant<is_pair_bitwise_copyable_v<Key, T>>
+{
 };
 
+// Moves rhs into lhs without calling any constructor. rhs is left holding the old lhs, or
+// untouched when destroying lhs is a no-op, and must be destroyed right after.
+template <class Key, class T, class Pair, class ErasePolicy>
+void bitwise_swap(
+    node<Key, T, Pair, ErasePolicy>& lhs, node<Key, T, Pair, ErasePolicy>& rhs) noexcept
+{
+    static_assert(is_pair_trivially_relocatable_v<Key, T>, "The node must be relocatable.");
+
+    if constexpr (is_pair_bitwise_copyable_v<Key, T>)
+    {
+        std::memcpy(static_cast<void*>(&lhs), static_cast<const void*>(&rhs), sizeof(lhs));
+    }
+    else
+    {
+        alignas(node<Key, T, Pair, ErasePolicy>) unsigned char buffer[sizeof(lhs)];
+        std::memcpy(buffer, static_cast<const void*>(&lhs), sizeof(lhs));
+        std::memcpy(static_cast<void*>(&lhs), static_cast<const void*>(&rhs), sizeof(lhs));
+        std::memcpy(static_cast<void*>(&rhs), buffer, sizeof(lhs));
+    }
+}
+
 } // namespace jg::details
 
+namespace jg
+{
+template <class Key, class T, class Pair, class ErasePolicy>
+struct is_trivially_relocatable<details::node<Key, T, Pair, ErasePolicy>>
+    : std::bool_constant<details::is_pair_trivially_relocatable_v<Key, T>>
+{
+};
+} // namespace jg
+
 namespace std
 {
-template <class Key, class T, class Allocator>
-struct uses_allocator<jg::details::node<Key, T>, Allocator> : true_type
+template <class Key, class T, class Pair, class ErasePolicy, class Allocator>
+struct uses_allocator<jg::details::node<Key, T, Pair, ErasePolicy>, Allocator> : true_type
 {
 };
 } // namespace std
@@ -0,0 +1,104 @@
+#ifndef JG_NODE_HANDLE_HPP
+#define JG_NODE_HANDLE_HPP
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace jg
+{
+
+template <class, class, class, class, class, class, class, class>
+class dense_hash_map;
+
+namespace details
+{
+    // Owns an element extracted from a dense_hash_map. The nodes of the map are stored next to
+    // each other and cannot be handed over one by one, so the key and the value are moved in and
+    // out of the handle instead.
+    template <class Key, class T, class Allocator>
+    class node_handle
+    {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using allocator_type = Allocator;
+
+        constexpr node_handle() noexcept = default;
+
+        node_handle(node_handle&& other) noexcept(
+            std::is_nothrow_move_constructible_v<std::pair<Key, T>>)
+            : allocator_(std::move(other.allocator_)), pair_(std::move(other.pair_))
+        {
+            other.reset();
+        }
+
+        auto operator=(node_handle&& other) noexcept(
+            std::is_nothrow_move_constructible_v<std::pair<Key, T>>) -> node_handle&
+        {
+            allocator_ = std::move(other.allocator_);
+            pair_ = std::move(other.pair_);
+            other.reset();
+            return *this;
+        }
+
+        [[nodiscard]] auto empty() const noexcept -> bool { return !pair_.has_value(); }
+
+        explicit operator bool() const noexcept { return pair_.has_value(); }
+
+        auto get_allocator() const -> allocator_type { return *allocator_; }
+
+        auto key() noexcept -> key_type& { return pair_->first; }
+
+        auto key() const noexcept -> const key_type& { return pair_->first; }
+
+        auto mapped() noexcept -> mapped_type& { return pair_->second; }
+
+        auto mapped() const noexcept -> const mapped_type& { return pair_->second; }
+
+        void swap(node_handle& other) noexcept(
+            std::is_nothrow_move_constructible_v<std::pair<Key, T>> &&
+            std::is_nothrow_swappable_v<std::pair<Key, T>>)
+        {
+            using std::swap;
+            swap(allocator_, other.allocator_);
+            swap(pair_, other.pair_);
+        }
+
+        friend void swap(node_handle& lhs, node_handle& rhs) noexcept(noexcept(lhs.swap(rhs)))
+        {
+            lhs.swap(rhs);
+        }
+
+    private:
+        template <class, class, class, class, class, class, class, class>
+        friend class jg::dense_hash_map;
+
+        template <class Pair>
+        node_handle(const Allocator& alloc, Pair&& pair)
+            : allocator_(alloc), pair_(std::forward<Pair>(pair))
+        {}
+
+        void reset() noexcept
+        {
+            allocator_.reset();
+            pair_.reset();
+        }
+
+        std::optional<allocator_type> allocator_;
+        std::optional<std::pair<Key, T>> pair_;
+    };
+
+    template <class Iterator, class NodeType>
+    struct insert_return_type
+    {
+        Iterator position;
+        bool inserted;
+        NodeType node;
+    };
+
+} // namespace details
+
+} // namespace jg
+
+#endif // JG_NODE_HANDLE_HPP
@@ -0,0 +1,156 @@
+#ifndef JG_PARALLEL_HPP
+#define JG_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jg
+{
+
+// Asks the bulk operations of dense_hash_map to spread their work over several threads. A
+// thread_count of 0 uses one thread per hardware thread. The hasher and the key equal are then
+// called concurrently and must be safe to use from several threads at once.
+struct parallel_policy
+{
+    std::size_t thread_count = 0;
+};
+
+namespace details
+{
+    // Below that many elements per thread, starting the threads costs more than it saves.
+    static constexpr const std::size_t min_parallel_work = 4096u;
+
+    // Amount of elements claimed at once by a worker iterating over elements.
+    static constexpr const std::size_t parallel_chunk_size = 16384u;
+
+    [[nodiscard]] inline auto resolve_thread_count(parallel_policy policy, std::size_t work_count)
+        -> std::size_t
+    {
+        std::size_t thread_count = policy.thread_count;
+
+        if (thread_count == 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        return std::max<std::size_t>(1u, std::min(thread_count, work_count / min_parallel_work));
+    }
+
+    // The [begin, end) range of count elements statically assigned to a worker.
+    [[nodiscard]] inline auto worker_slice(
+        std::size_t worker, std::size_t thread_count, std::size_t count)
+        -> std::pair<std::size_t, std::size_t>
+    {
+        return {count * worker / thread_count, count * (worker + 1) / thread_count};
+    }
+
+    // Calls f(worker) for every worker in [0, thread_count), the calling thread being worker 0.
+    // The first exception thrown by a worker is rethrown once all of them are done.
+    template <class F>
+    void run_workers(std::size_t thread_count, const F& f)
+    {
+        if (thread_count <= 1)
+        {
+            f(std::size_t{0});
+            return;
+        }
+
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        const auto guarded_f = [&](std::size_t worker) {
+#ifdef JG_NO_EXCEPTION
+            f(worker);
+#else
+            try
+            {
+                f(worker);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(error_mutex);
+
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+#endif
+        };
+
+        std::vector<std::thread> threads;
+
+        const auto join_all = [&threads] {
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        };
+
+#ifdef JG_NO_EXCEPTION
+        threads.reserve(thread_count - 1);
+
+        for (std::size_t worker = 1; worker < thread_count; ++worker)
+        {
+            threads.emplace_back(guarded_f, worker);
+        }
+#else
+        try
+        {
+            threads.reserve(thread_count - 1);
+
+            for (std::size_t worker = 1; worker < thread_count; ++worker)
+            {
+                threads.emplace_back(guarded_f, worker);
+            }
+        }
+        catch (...)
+        {
+            join_all();
+            throw;
+        }
+#endif
+
+        guarded_f(0);
+        join_all();
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Splits [0, count) into chunks claimed by the workers as they go, so that the fast workers
+    // pick up the remaining work of the slow ones. Calls f(begin, end) for every chunk.
+    template <class F>
+    void parallel_for_chunks(
+        std::size_t thread_count, std::size_t count, std::size_t chunk_size, const F& f)
+    {
+        std::atomic<std::size_t> next_chunk{0};
+
+        run_workers(thread_count, [&](std::size_t) {
+            for (;;)
+            {
+                const auto begin = next_chunk.fetch_add(chunk_size, std::memory_order_relaxed);
+
+                if (begin >= count)
+                {
+                    return;
+                }
+
+                f(begin, std::min(begin + chunk_size, count));
+            }
+        });
+    }
+
+} // namespace details
+
+} // namespace jg
+
+#endif // JG_PARALLEL_HPP
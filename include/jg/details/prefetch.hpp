@@ -0,0 +1,25 @@
+#ifndef JG_PREFETCH_HPP
+#define JG_PREFETCH_HPP
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace jg::details
+{
+
+// Hints the CPU to start loading the cache line of address. This is only a hint, it never faults.
+inline void prefetch(const void* address) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    static_cast<void>(address);
+#endif
+}
+
+} // namespace jg::details
+
+#endif // JG_PREFETCH_HPP
@@ -0,0 +1,58 @@
+#ifndef JG_RADIX_SORT_HPP
+#define JG_RADIX_SORT_HPP
+
+#include <cstddef>
+#include <limits>
+
+namespace jg::details
+{
+
+struct bucketed_position
+{
+    std::size_t bindex;
+    std::size_t position;
+};
+
+// Stable LSD radix sort of the entries on their bucket index. Digits are 11 bits wide so that the
+// histogram stays in the L1 cache, and every pass streams through memory sequentially.
+template <class Container>
+void radix_sort_by_bucket(Container& entries, Container& scratch, std::size_t bucket_count)
+{
+    constexpr std::size_t digit_bits = 11u;
+    constexpr std::size_t digit_count = std::size_t{1} << digit_bits;
+    constexpr std::size_t digit_mask = digit_count - 1;
+
+    const std::size_t max_bindex = bucket_count - 1;
+    scratch.resize(entries.size());
+
+    for (std::size_t shift = 0;
+         shift < std::numeric_limits<std::size_t>::digits && (max_bindex >> shift) != 0;
+         shift += digit_bits)
+    {
+        std::size_t histogram[digit_count] = {};
+
+        for (const auto& entry : entries)
+        {
+            ++histogram[(entry.bindex >> shift) & digit_mask];
+        }
+
+        std::size_t offset = 0;
+        for (auto& count : histogram)
+        {
+            const auto digit_size = count;
+            count = offset;
+            offset += digit_size;
+        }
+
+        for (const auto& entry : entries)
+        {
+            scratch[histogram[(entry.bindex >> shift) & digit_mask]++] = entry;
+        }
+
+        entries.swap(scratch);
+    }
+}
+
+} // namespace jg::details
+
+#endif // JG_RADIX_SORT_HPP
@@ -0,0 +1,22 @@
+#ifndef JG_SEGMENTED_NODES_CONTAINER_POLICY_HPP
+#define JG_SEGMENTED_NODES_CONTAINER_POLICY_HPP
+
+#include "segmented_vector.hpp"
+
+#include <cstddef>
+
+namespace jg::details
+{
+
+// Stores the nodes in segments of SegmentSize nodes. Growing the map never copies or moves the
+// existing nodes, which avoids the 2x peak memory of a std::vector reallocation on huge maps.
+template <std::size_t SegmentSize = 4096u>
+struct segmented_nodes_container_policy
+{
+    template <class Node, class Allocator>
+    using container = segmented_vector<Node, Allocator, SegmentSize>;
+};
+
+} // namespace jg::details
+
+#endif // JG_SEGMENTED_NODES_CONTAINER_POLICY_HPP
@@ -0,0 +1,498 @@
+#ifndef JG_SEGMENTED_VECTOR_HPP
+#define JG_SEGMENTED_VECTOR_HPP
+
+#include "type_traits.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jg::details
+{
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst>
+class segmented_vector_iterator
+{
+    friend segmented_vector_iterator<T, Pointer, SegmentShift, true>;
+
+    static constexpr std::size_t segment_mask = (std::size_t{1} << SegmentShift) - 1;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<isConst, const T&, T&>;
+    using pointer = std::conditional_t<isConst, const T*, T*>;
+
+    constexpr segmented_vector_iterator() noexcept = default;
+
+    constexpr segmented_vector_iterator(const Pointer* segments, std::size_t index) noexcept
+        : segments_(segments), index_(index)
+    {}
+
+    template <bool DepIsConst = isConst, std::enable_if_t<DepIsConst, int> = 0>
+    constexpr segmented_vector_iterator(
+        const segmented_vector_iterator<T, Pointer, SegmentShift, false>& other) noexcept
+        : segments_(other.segments_), index_(other.index_)
+    {}
+
+    constexpr auto operator*() const noexcept -> reference
+    {
+        return segments_[index_ >> SegmentShift][index_ & segment_mask];
+    }
+
+    constexpr auto operator-> () const noexcept -> pointer { return std::addressof(**this); }
+
+    constexpr auto operator[](difference_type n) const noexcept -> reference
+    {
+        return *(*this + n);
+    }
+
+    constexpr auto operator++() noexcept -> segmented_vector_iterator&
+    {
+        ++index_;
+        return *this;
+    }
+
+    constexpr auto operator++(int) noexcept -> segmented_vector_iterator
+    {
+        auto old = *this;
+        ++index_;
+        return old;
+    }
+
+    constexpr auto operator--() noexcept -> segmented_vector_iterator&
+    {
+        --index_;
+        return *this;
+    }
+
+    constexpr auto operator--(int) noexcept -> segmented_vector_iterator
+    {
+        auto old = *this;
+        --index_;
+        return old;
+    }
+
+    constexpr auto operator+=(difference_type n) noexcept -> segmented_vector_iterator&
+    {
+        index_ += n;
+        return *this;
+    }
+
+    constexpr auto operator-=(difference_type n) noexcept -> segmented_vector_iterator&
+    {
+        index_ -= n;
+        return *this;
+    }
+
+    constexpr auto operator+(difference_type n) const noexcept -> segmented_vector_iterator
+    {
+        return segmented_vector_iterator{segments_, index_ + n};
+    }
+
+    friend constexpr auto
+    operator+(difference_type n, const segmented_vector_iterator& it) noexcept
+        -> segmented_vector_iterator
+    {
+        return it + n;
+    }
+
+    constexpr auto operator-(difference_type n) const noexcept -> segmented_vector_iterator
+    {
+        return segmented_vector_iterator{segments_, index_ - n};
+    }
+
+    constexpr auto index() const noexcept -> std::size_t { return index_; }
+
+private:
+    const Pointer* segments_ = nullptr;
+    std::size_t index_ = 0;
+};
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator-(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept
+    -> std::ptrdiff_t
+{
+    return static_cast<std::ptrdiff_t>(lhs.index() - rhs.index());
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator==(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() == rhs.index();
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator!=(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() != rhs.index();
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator<(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() < rhs.index();
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator>(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() > rhs.index();
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator<=(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() <= rhs.index();
+}
+
+template <class T, class Pointer, std::size_t SegmentShift, bool isConst, bool isConst2>
+constexpr auto operator>=(
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst>& lhs,
+    const segmented_vector_iterator<T, Pointer, SegmentShift, isConst2>& rhs) noexcept -> bool
+{
+    return lhs.index() >= rhs.index();
+}
+
+// A vector made of fixed-size segments referenced by a directory. Growing it allocates a new
+// segment and never moves the elements already stored, so there is no transient 2x peak of memory
+// and no stall while relocating. Only the (small) directory of segment pointers is reallocated.
+template <class T, class Allocator, std::size_t SegmentSize>
+class segmented_vector
+{
+    static_assert(
+        SegmentSize > 0 && (SegmentSize & (SegmentSize - 1)) == 0,
+        "The segment size must be a power of two.");
+
+    using allocator_traits = std::allocator_traits<Allocator>;
+    using segment_pointer = typename allocator_traits::pointer;
+    using directory_type = std::vector<
+        segment_pointer, typename allocator_traits::template rebind_alloc<segment_pointer>>;
+
+    static constexpr std::size_t compute_shift(std::size_t size)
+    {
+        std::size_t shift = 0;
+        while ((std::size_t{1} << shift) < size)
+        {
+            ++shift;
+        }
+        return shift;
+    }
+
+    static constexpr std::size_t segment_shift = compute_shift(SegmentSize);
+    static constexpr std::size_t segment_mask = SegmentSize - 1;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = typename allocator_traits::pointer;
+    using const_pointer = typename allocator_traits::const_pointer;
+    using iterator = segmented_vector_iterator<T, segment_pointer, segment_shift, false>;
+    using const_iterator = segmented_vector_iterator<T, segment_pointer, segment_shift, true>;
+
+    segmented_vector() noexcept(std::is_nothrow_default_constructible_v<Allocator>)
+        : segmented_vector(Allocator())
+    {}
+
+    explicit segmented_vector(const Allocator& alloc) noexcept
+        : allocator_(alloc), segments_(alloc)
+    {}
+
+    segmented_vector(const segmented_vector& other)
+        : segmented_vector(
+              other, allocator_traits::select_on_container_copy_construction(other.allocator_))
+    {}
+
+    segmented_vector(const segmented_vector& other, const Allocator& alloc)
+        : segmented_vector(alloc)
+    {
+        append_copies(other);
+    }
+
+    segmented_vector(segmented_vector&& other) noexcept
+        : allocator_(other.allocator_)
+        , segments_(std::move(other.segments_))
+        , size_(std::exchange(other.size_, 0u))
+    {
+        other.segments_.clear();
+    }
+
+    segmented_vector(segmented_vector&& other, const Allocator& alloc) : segmented_vector(alloc)
+    {
+        if (allocator_ == other.allocator_)
+        {
+            segments_.swap(other.segments_);
+            size_ = std::exchange(other.size_, 0u);
+        }
+        else
+        {
+            append_moves(other);
+        }
+    }
+
+    ~segmented_vector() { release(); }
+
+    auto operator=(const segmented_vector& other) -> segmented_vector&
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+
+        if constexpr (allocator_traits::propagate_on_container_copy_assignment::value)
+        {
+            if (allocator_ != other.allocator_)
+            {
+                release();
+                segments_ = directory_type(other.allocator_);
+            }
+
+            allocator_ = other.allocator_;
+        }
+
+        append_copies(other);
+        return *this;
+    }
+
+    auto operator=(segmented_vector&& other) noexcept(
+        allocator_traits::propagate_on_container_move_assignment::value ||
+        allocator_traits::is_always_equal::value) -> segmented_vector&
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        if constexpr (
+            allocator_traits::propagate_on_container_move_assignment::value ||
+            allocator_traits::is_always_equal::value)
+        {
+            release();
+            if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+            {
+                allocator_ = std::move(other.allocator_);
+            }
+            segments_ = std::move(other.segments_);
+            other.segments_.clear();
+            size_ = std::exchange(other.size_, 0u);
+        }
+        else
+        {
+            if (allocator_ == other.allocator_)
+            {
+                release();
+                segments_.swap(other.segments_);
+                size_ = std::exchange(other.size_, 0u);
+            }
+            else
+            {
+                clear();
+                append_moves(other);
+            }
+        }
+
+        return *this;
+    }
+
+    void swap(segmented_vector& other) noexcept
+    {
+        using std::swap;
+        if constexpr (allocator_traits::propagate_on_container_swap::value)
+        {
+            swap(allocator_, other.allocator_);
+        }
+        segments_.swap(other.segments_);
+        swap(size_, other.size_);
+    }
+
+    friend void swap(segmented_vector& lhs, segmented_vector& rhs) noexcept { lhs.swap(rhs); }
+
+    auto get_allocator() const -> allocator_type { return allocator_; }
+
+    auto begin() noexcept -> iterator { return iterator{segments_.data(), 0u}; }
+    auto begin() const noexcept -> const_iterator { return const_iterator{segments_.data(), 0u}; }
+    auto cbegin() const noexcept -> const_iterator { return begin(); }
+
+    auto end() noexcept -> iterator { return iterator{segments_.data(), size_}; }
+    auto end() const noexcept -> const_iterator { return const_iterator{segments_.data(), size_}; }
+    auto cend() const noexcept -> const_iterator { return end(); }
+
+    auto size() const noexcept -> size_type { return size_; }
+
+    auto capacity() const noexcept -> size_type { return segments_.size() * SegmentSize; }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0u; }
+
+    auto max_size() const noexcept -> size_type
+    {
+        return static_cast<size_type>(std::numeric_limits<difference_type>::max()) / sizeof(T);
+    }
+
+    auto operator[](size_type index) noexcept -> reference
+    {
+        return segments_[index >> segment_shift][index & segment_mask];
+    }
+
+    auto operator[](size_type index) const noexcept -> const_reference
+    {
+        return segments_[index >> segment_shift][index & segment_mask];
+    }
+
+    auto back() noexcept -> reference { return (*this)[size_ - 1]; }
+
+    auto back() const noexcept -> const_reference { return (*this)[size_ - 1]; }
+
+    template <class... Args>
+    auto emplace_back(Args&&... args) -> reference
+    {
+        if (size_ == capacity())
+        {
+            add_segment();
+        }
+
+        auto& slot = (*this)[size_];
+        allocator_traits::construct(allocator_, std::addressof(slot), std::forward<Args>(args)...);
+        ++size_;
+        return slot;
+    }
+
+    void pop_back() noexcept
+    {
+        --size_;
+        allocator_traits::destroy(allocator_, std::addressof((*this)[size_]));
+    }
+
+    void clear() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for (size_type i = 0; i < size_; ++i)
+            {
+                allocator_traits::destroy(allocator_, std::addressof((*this)[i]));
+            }
+        }
+
+        size_ = 0u;
+    }
+
+    void reserve(size_type count)
+    {
+        if (count > capacity())
+        {
+            segments_.reserve((count + segment_mask) >> segment_shift);
+        }
+
+        while (count > capacity())
+        {
+            add_segment();
+        }
+    }
+
+    void shrink_to_fit()
+    {
+        const auto needed_segments = (size_ + segment_mask) >> segment_shift;
+
+        while (segments_.size() > needed_segments)
+        {
+            allocator_traits::deallocate(allocator_, segments_.back(), SegmentSize);
+            segments_.pop_back();
+        }
+
+        segments_.shrink_to_fit();
+    }
+
+private:
+    void add_segment()
+    {
+        // Grow the directory first so that push_back cannot throw once the segment is allocated.
+        if (segments_.size() == segments_.capacity())
+        {
+            segments_.reserve(std::max<size_type>(8u, segments_.capacity() * 2));
+        }
+
+        segments_.push_back(allocator_traits::allocate(allocator_, SegmentSize));
+    }
+
+    void release() noexcept
+    {
+        clear();
+
+        for (auto segment : segments_)
+        {
+            allocator_traits::deallocate(allocator_, segment, SegmentSize);
+        }
+
+        segments_.clear();
+    }
+
+    void append_copies(const segmented_vector& other)
+    {
+        reserve(size_ + other.size());
+
+        if constexpr (is_bitwise_copyable_v<T>)
+        {
+            if (size_ == 0u)
+            {
+                // Whole segments are copied at once.
+                for (size_type i = 0; i < other.size(); i += SegmentSize)
+                {
+                    std::memcpy(
+                        static_cast<void*>(std::addressof((*this)[i])),
+                        static_cast<const void*>(std::addressof(other[i])),
+                        std::min(SegmentSize, other.size() - i) * sizeof(T));
+                }
+
+                size_ = other.size();
+                return;
+            }
+        }
+
+        for (size_type i = 0; i < other.size(); ++i)
+        {
+            emplace_back(other[i]);
+        }
+    }
+
+    void append_moves(segmented_vector& other)
+    {
+        reserve(size_ + other.size());
+
+        for (size_type i = 0; i < other.size(); ++i)
+        {
+            emplace_back(std::move(other[i]));
+        }
+    }
+
+    Allocator allocator_;
+    directory_type segments_;
+    size_type size_ = 0u;
+};
+
+} // namespace jg::details
+
+#endif // JG_SEGMENTED_VECTOR_HPP
@@ -0,0 +1,176 @@
+#ifndef JG_STABLE_HANDLES_HPP
+#define JG_STABLE_HANDLES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jg
+{
+
+// Refers to an element of a dense_hash_map using an erase policy with stable handles. It survives
+// the erasure of the other elements and the rehashes, and goes stale once its element is erased
+// instead of referring to whichever element comes next.
+struct stable_handle
+{
+    std::uint32_t slot = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t generation = 0;
+};
+
+constexpr auto operator==(const stable_handle& lhs, const stable_handle& rhs) noexcept -> bool
+{
+    return lhs.slot == rhs.slot && lhs.generation == rhs.generation;
+}
+
+constexpr auto operator!=(const stable_handle& lhs, const stable_handle& rhs) noexcept -> bool
+{
+    return !(lhs == rhs);
+}
+
+namespace details
+{
+    using slot_index_t = std::uint32_t;
+
+    static constexpr const slot_index_t no_slot = std::numeric_limits<slot_index_t>::max();
+
+    // Maps the slots of the stable handles to the indices of their nodes. The free slots are
+    // chained through their node index, and their generation is bumped when they are released so
+    // that the handles to them go stale.
+    template <class Allocator>
+    class slot_table
+    {
+    public:
+        explicit slot_table(const Allocator& alloc) : slots_(alloc) {}
+
+        slot_table(const slot_table& other) = default;
+
+        slot_table(const slot_table& other, const Allocator& alloc)
+            : slots_(other.slots_, alloc), free_head_(other.free_head_)
+        {}
+
+        slot_table(slot_table&& other) noexcept
+            : slots_(std::move(other.slots_)), free_head_(std::exchange(other.free_head_, no_slot))
+        {}
+
+        slot_table(slot_table&& other, const Allocator& alloc)
+            : slots_(std::move(other.slots_), alloc)
+            , free_head_(std::exchange(other.free_head_, no_slot))
+        {}
+
+        auto operator=(const slot_table& other) -> slot_table& = default;
+
+        auto operator=(slot_table&& other) noexcept(
+            std::is_nothrow_move_assignable_v<slots_container_type>) -> slot_table&
+        {
+            slots_ = std::move(other.slots_);
+            free_head_ = std::exchange(other.free_head_, no_slot);
+            return *this;
+        }
+
+        // Makes room so that the next acquire() does not throw.
+        void prepare_acquire()
+        {
+            if (free_head_ == no_slot && slots_.size() == slots_.capacity())
+            {
+                slots_.reserve(std::max<std::size_t>(8u, slots_.size() * 2u));
+            }
+        }
+
+        auto acquire(std::size_t node_index) -> slot_index_t
+        {
+            if (free_head_ == no_slot)
+            {
+                slots_.push_back({static_cast<slot_index_t>(node_index), 0u});
+                return static_cast<slot_index_t>(slots_.size() - 1u);
+            }
+
+            const auto slot = free_head_;
+            free_head_ = slots_[slot].node_index;
+            slots_[slot].node_index = static_cast<slot_index_t>(node_index);
+
+            return slot;
+        }
+
+        void release(slot_index_t slot) noexcept
+        {
+            ++slots_[slot].generation;
+            slots_[slot].node_index = std::exchange(free_head_, slot);
+        }
+
+        // Releases every slot at once, when all the nodes are destroyed.
+        void release_all() noexcept
+        {
+            free_head_ = no_slot;
+
+            for (auto slot = slots_.size(); slot-- > 0u;)
+            {
+                release(static_cast<slot_index_t>(slot));
+            }
+        }
+
+        void relocate(slot_index_t slot, std::size_t node_index) noexcept
+        {
+            slots_[slot].node_index = static_cast<slot_index_t>(node_index);
+        }
+
+        auto handle(slot_index_t slot) const noexcept -> stable_handle
+        {
+            return {slot, slots_[slot].generation};
+        }
+
+        // The index of the node a handle refers to, or no_slot when the handle is stale.
+        auto node_index(stable_handle handle) const noexcept -> std::size_t
+        {
+            if (handle.slot >= slots_.size() || slots_[handle.slot].generation != handle.generation)
+            {
+                return no_slot;
+            }
+
+            return slots_[handle.slot].node_index;
+        }
+
+        void swap(slot_table& other) noexcept(std::is_nothrow_swappable_v<slots_container_type>)
+        {
+            using std::swap;
+            swap(slots_, other.slots_);
+            swap(free_head_, other.free_head_);
+        }
+
+        friend void swap(slot_table& lhs, slot_table& rhs) noexcept(noexcept(lhs.swap(rhs)))
+        {
+            lhs.swap(rhs);
+        }
+
+    private:
+        struct slot_entry
+        {
+            slot_index_t node_index;
+            std::uint32_t generation;
+        };
+
+        using slots_container_type = std::vector<
+            slot_entry,
+            typename std::allocator_traits<Allocator>::template rebind_alloc<slot_entry>>;
+
+        slots_container_type slots_;
+        slot_index_t free_head_ = no_slot;
+    };
+
+    // Takes the place of slot_table in the maps without stable handles.
+    struct no_slot_table
+    {
+        template <class... Args>
+        constexpr explicit no_slot_table(const Args&... /*args*/) noexcept
+        {}
+    };
+
+} // namespace details
+
+} // namespace jg
+
+#endif // JG_STABLE_HANDLES_HPP
@@ -2,6 +2,7 @@
 #define JG_TYPE_TRAITS
 
 #include <type_traits>
+#include <utility>
 
 namespace jg::details
 {
@@ -42,6 +43,40 @@ using detected_t = typename detail::detector<nonesuch, void, Op, Args...>::type;
 template <class Default, template <class...> class Op, class... Args>
 using detected_or = detail::detector<Default, void, Op, Args...>;
 
+// Tells whether copying the object representation with memcpy is a valid copy construction.
+// Specialized for the nodes of dense_hash_map which are not trivially copyable on their own.
+template <class T>
+struct is_bitwise_copyable : std::is_trivially_copyable<T>
+{
+};
+
+template <class T>
+inline constexpr bool is_bitwise_copyable_v = is_bitwise_copyable<T>::value;
+
 } // namespace jg::details
 
+namespace jg
+{
+
+// Specialize this trait to std::true_type for types that can be moved to another address with
+// memcpy, the source being considered dead afterwards without running its destructor. It must only
+// be set for types holding no pointer into themselves: std::string with a small string buffer, for
+// instance, does not qualify. dense_hash_map relies on it when erasing, to relocate the last node.
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T>
+{
+};
+
+template <class First, class Second>
+struct is_trivially_relocatable<std::pair<First, Second>>
+    : std::bool_constant<
+          is_trivially_relocatable<First>::value && is_trivially_relocatable<Second>::value>
+{
+};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+} // namespace jg
+
 #endif // JG_TYPE_TRAITS
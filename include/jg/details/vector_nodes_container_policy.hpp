@@ -0,0 +1,27 @@
+#ifndef JG_VECTOR_NODES_CONTAINER_POLICY_HPP
+#define JG_VECTOR_NODES_CONTAINER_POLICY_HPP
+
+#include <vector>
+
+namespace jg::details
+{
+
+// A nodes container policy tells dense_hash_map where to store its nodes through a
+// container<Node, Allocator> alias template. The container must provide:
+// - size_type equal to std::size_t (node indices are stored in the buckets), difference_type,
+//   iterator and const_iterator which must be random access iterators,
+// - construction from an allocator, copy/move construction with an allocator, copy/move
+//   assignment and swap, get_allocator(),
+// - begin(), end(), cbegin(), cend(), size(), empty(), max_size(), operator[], back(),
+// - emplace_back(args...), pop_back(), clear(), capacity(), reserve(n), shrink_to_fit().
+// Elements must be constructed through std::allocator_traits<Allocator>::construct so that
+// uses-allocator construction keeps working. The storage can be contiguous or segmented.
+struct vector_nodes_container_policy
+{
+    template <class Node, class Allocator>
+    using container = std::vector<Node, Allocator>;
+};
+
+} // namespace jg::details
+
+#endif // JG_VECTOR_NODES_CONTAINER_POLICY_HPP
@@ -0,0 +1,173 @@
+#ifndef JG_HASH_AGGREGATOR_HPP
+#define JG_HASH_AGGREGATOR_HPP
+
+#include "dense_hash_map.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace jg
+{
+
+// An aggregate tells hash_aggregator how to fold the values of a group. lift(value) gives the
+// result of a group made of that value alone, and combine(result, lifted) folds a lifted value into
+// the result of its group in place.
+
+struct sum_aggregate
+{
+    template <class Value>
+    using result_type = Value;
+
+    template <class Value>
+    static constexpr auto lift(const Value& value) -> Value
+    {
+        return value;
+    }
+
+    template <class Result>
+    static constexpr void combine(Result& result, const Result& lifted)
+    {
+        result += lifted;
+    }
+};
+
+struct count_aggregate
+{
+    template <class Value>
+    using result_type = std::size_t;
+
+    template <class Value>
+    static constexpr auto lift(const Value& /*value*/) -> std::size_t
+    {
+        return 1u;
+    }
+
+    static constexpr void combine(std::size_t& result, std::size_t lifted) { result += lifted; }
+};
+
+struct min_aggregate
+{
+    template <class Value>
+    using result_type = Value;
+
+    template <class Value>
+    static constexpr auto lift(const Value& value) -> Value
+    {
+        return value;
+    }
+
+    template <class Result>
+    static constexpr void combine(Result& result, const Result& lifted)
+    {
+        result = std::min(result, lifted);
+    }
+};
+
+struct max_aggregate
+{
+    template <class Value>
+    using result_type = Value;
+
+    template <class Value>
+    static constexpr auto lift(const Value& value) -> Value
+    {
+        return value;
+    }
+
+    template <class Result>
+    static constexpr void combine(Result& result, const Result& lifted)
+    {
+        result = std::max(result, lifted);
+    }
+};
+
+// Group-by stage folding columns of keys and values into one result per distinct key. The keys of
+// a batch are all hashed first and their buckets prefetched, then every row is folded into its
+// group with a single chain walk. The groups live in the contiguous nodes of a dense_hash_map, in
+// the order they were first seen, so exporting them is a linear walk.
+template <
+    class Key, class Value, class Aggregate, class Hash = std::hash<Key>,
+    class Pred = std::equal_to<Key>,
+    class Allocator =
+        std::allocator<std::pair<const Key, typename Aggregate::template result_type<Value>>>>
+class hash_aggregator
+{
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using aggregate_type = Aggregate;
+    using result_type = typename Aggregate::template result_type<Value>;
+    using map_type = dense_hash_map<Key, result_type, Hash, Pred, Allocator>;
+    using size_type = typename map_type::size_type;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using allocator_type = Allocator;
+
+    hash_aggregator() = default;
+
+    explicit hash_aggregator(
+        size_type expected_groups, const Hash& hash = Hash(), const Pred& equal = Pred(),
+        const Allocator& alloc = Allocator())
+        : groups_(0u, hash, equal, alloc)
+    {
+        groups_.reserve(expected_groups);
+    }
+
+    // Folds the rows [keys_first, keys_last) into their groups, the value of the row keys_first[i]
+    // being values_first[i].
+    template <class KeyIt, class ValueIt>
+    void consume(KeyIt keys_first, KeyIt keys_last, ValueIt values_first)
+    {
+        const auto combine = [](result_type& result, const result_type& lifted) {
+            Aggregate::combine(result, lifted);
+        };
+
+        groups_.for_each_prehashed(
+            keys_first, keys_last, details::identity{}, [&](precomputed_hash hash, const Key& key) {
+                groups_.upsert(key, hash, Aggregate::lift(*values_first), combine);
+                ++values_first;
+            });
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return groups_.empty(); }
+
+    auto size() const noexcept -> size_type { return groups_.size(); }
+
+    // The groups, iterated in the order of their nodes.
+    auto groups() const noexcept -> const map_type& { return groups_; }
+
+    // Hands the groups over, leaving the aggregator empty.
+    auto release() -> map_type
+    {
+        map_type groups = std::move(groups_);
+        groups_.clear();
+        return groups;
+    }
+
+    // Writes the keys and the results of the groups to two columns, in the order of their nodes.
+    template <class KeyOut, class ResultOut>
+    auto export_columns(KeyOut keys_out, ResultOut results_out) const
+        -> std::pair<KeyOut, ResultOut>
+    {
+        for (const auto& [key, result] : groups_)
+        {
+            *keys_out++ = key;
+            *results_out++ = result;
+        }
+
+        return {keys_out, results_out};
+    }
+
+    void clear() noexcept { groups_.clear(); }
+
+private:
+    map_type groups_;
+};
+
+} // namespace jg
+
+#endif // JG_HASH_AGGREGATOR_HPP
@@ -2,11 +2,16 @@
 
 #include "catch2/catch.hpp"
 #include "jg/dense_hash_map.hpp"
+#include "jg/hash_aggregator.hpp"
 #include "jg/details/type_traits.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <list>
 #include <memory_resource>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace
@@ -165,6 +170,145 @@ struct counting_pmr_resource : std::pmr::memory_resource
 
     int* alloc_counter = nullptr;
 };
+
+struct counting_hash
+{
+    auto operator()(const std::string& key) const -> std::size_t
+    {
+        ++*counter;
+        return std::hash<std::string>{}(key);
+    }
+
+    int* counter = nullptr;
+};
+
+struct construction_counter
+{
+    explicit construction_counter(int* counter) { ++*counter; }
+};
+
+struct string_view_hash
+{
+    using transparent_key_equal = std::equal_to<>;
+    auto operator()(std::string_view s) const -> std::size_t
+    {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+// A key which counts how many times it is converted from a string_view.
+struct counted_key
+{
+    explicit counted_key(std::string_view v) : value(v) { ++conversions; }
+
+    std::string value;
+    static inline int conversions = 0;
+};
+
+auto operator==(const counted_key& lhs, std::string_view rhs) -> bool { return lhs.value == rhs; }
+
+struct counted_key_hash
+{
+    using is_transparent = void;
+
+    auto operator()(std::string_view s) const -> std::size_t
+    {
+        return std::hash<std::string_view>{}(s);
+    }
+
+    auto operator()(const counted_key& key) const -> std::size_t { return (*this)(key.value); }
+};
+
+template <class It>
+using detect_iterator_advance = decltype(std::declval<It>() + 1);
+
+template <class It>
+using detect_iterator_distance = decltype(std::declval<It>() - std::declval<It>());
+
+struct back_linked_tombstone_erase_policy
+{
+    static constexpr bool back_links = true;
+    static constexpr bool tombstones = true;
+};
+
+// Map of the randomized erase tests, only differing in their erase policy.
+template <class Key, class T, class ErasePolicy, class Hash = std::hash<Key>>
+using erase_policy_map = jg::dense_hash_map<
+    Key, T, Hash, std::equal_to<Key>, std::allocator<std::pair<const Key, T>>,
+    jg::details::power_of_two_growth_policy, jg::details::vector_nodes_container_policy,
+    ErasePolicy>;
+
+// Deterministic pseudo-random numbers for the randomized tests.
+class lcg_random
+{
+public:
+    explicit lcg_random(std::uint32_t seed) : seed_(seed) {}
+
+    auto operator()() -> std::uint32_t { return (seed_ = seed_ * 1664525u + 1013904223u) >> 8; }
+
+private:
+    std::uint32_t seed_;
+};
+
+// Erases by key and by iterator and inserts at random, checking m against std::unordered_map.
+template <class Map, class MakeValue>
+void random_erase_workload(Map m, MakeValue make_value, std::uint32_t seed)
+{
+    std::unordered_map<std::string, int> expected;
+    lcg_random next_random{seed};
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        const auto key = std::to_string(next_random() % 500);
+
+        if (next_random() % 3 == 0)
+        {
+            REQUIRE(m.erase(key) == expected.erase(key));
+        }
+        else if (next_random() % 5 == 0 && !m.empty())
+        {
+            const auto it = std::next(m.begin(), next_random() % m.size());
+            expected.erase(it->first);
+            m.erase(it);
+        }
+        else
+        {
+            m.try_emplace(key, make_value(i));
+            expected.try_emplace(key, i);
+        }
+    }
+
+    REQUIRE(m.size() == expected.size());
+    REQUIRE(static_cast<std::size_t>(std::distance(m.begin(), m.end())) == expected.size());
+
+    std::size_t chained = 0;
+    for (std::size_t n = 0; n < m.bucket_count(); ++n)
+    {
+        chained += std::distance(m.begin(n), m.end(n));
+    }
+    REQUIRE(chained == m.size());
+
+    for (const auto& [key, value] : expected)
+    {
+        if constexpr (std::is_same_v<typename Map::mapped_type, int>)
+        {
+            REQUIRE(m.at(key) == value);
+        }
+        else
+        {
+            REQUIRE(*m.at(key) == value);
+        }
+    }
+}
+
+struct derived_vector_policy
+{
+    template <class Node, class Allocator>
+    struct container : std::vector<Node, Allocator>
+    {
+        using std::vector<Node, Allocator>::vector;
+    };
+};
 } // namespace
 
 namespace std
@@ -179,6 +323,14 @@ struct hash<increase_counter_on_copy_or_move>
 };
 } // namespace std
 
+namespace jg
+{
+template <>
+struct is_trivially_relocatable<increase_counter_on_copy_or_move> : std::true_type
+{
+};
+} // namespace jg
+
 TEST_CASE("member types")
 {
     jg::dense_hash_map<std::string, int> m;
@@ -569,6 +721,47 @@ TEST_CASE("clear")
     SECTION("no_except") { REQUIRE(noexcept(m.clear())); }
 }
 
+TEST_CASE("clear_keep_capacity")
+{
+    jg::dense_hash_map<std::string, int> m;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        m.try_emplace(std::to_string(i), i);
+    }
+
+    const auto bucket_count = m.bucket_count();
+
+    SECTION("dense")
+    {
+        m.clear_keep_capacity();
+        REQUIRE(m.empty());
+        REQUIRE(m.bucket_count() == bucket_count);
+        REQUIRE(m.find("42") == m.end());
+    }
+
+    SECTION("sparse")
+    {
+        m.clear_keep_capacity();
+        m.try_emplace("tintin", 1);
+        m.try_emplace("milou", 2);
+
+        m.clear_keep_capacity();
+        REQUIRE(m.empty());
+        REQUIRE(m.bucket_count() == bucket_count);
+
+        for (std::size_t n = 0; n < m.bucket_count(); ++n)
+        {
+            REQUIRE(m.bucket_size(n) == 0);
+        }
+    }
+
+    m.try_emplace("haddock", 3);
+    REQUIRE(m.size() == 1);
+    REQUIRE(m.at("haddock") == 3);
+    REQUIRE(m.bucket_count() == bucket_count);
+}
+
 template <class T, class V>
 using has_insert = decltype(std::declval<T>().insert(std::declval<V>()));
 
@@ -688,6 +881,58 @@ TEST_CASE("insert")
         REQUIRE(it->second == 1337);
     }
 
+    SECTION("insert - iterator sizes once")
+    {
+        int counter = 0;
+        auto r = counting_pmr_resource(&counter);
+        jg::pmr::dense_hash_map<int, int> pm(8u, &r);
+
+        std::vector<std::pair<int, int>> values;
+        for (int i = 0; i < 10000; ++i)
+        {
+            values.emplace_back(i % 9000, i);
+        }
+
+        const auto old_counter = counter;
+        pm.insert(values.begin(), values.end());
+
+        REQUIRE((counter - old_counter) == 2); // buckets_ and nodes_ allocated once each.
+        REQUIRE(pm.size() == 9000);
+        for (int i = 0; i < 9000; ++i)
+        {
+            REQUIRE(pm.at(i) == i);
+        }
+    }
+
+    SECTION("insert - iterator gives back the room of duplicate keys")
+    {
+        std::vector<std::pair<std::string, int>> values(100000, {"tintin", 1});
+        const auto bucket_count = m.bucket_count();
+        m.insert(values.begin(), values.end());
+
+        REQUIRE(m.size() == 1);
+        REQUIRE(m.at("tintin") == 1);
+        REQUIRE(m.bucket_count() == bucket_count);
+
+        values.emplace_back("milou", 2);
+        m.insert(jg::parallel_policy{4}, values.begin(), values.end());
+
+        REQUIRE(m.size() == 2);
+        REQUIRE(m.at("milou") == 2);
+        REQUIRE(m.bucket_count() == bucket_count);
+    }
+
+    SECTION("insert - iterator / size_hint")
+    {
+        std::vector<std::pair<std::string, int>> values = {{"tintin", 1}, {"milou", 2}};
+        m.insert(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()), 2);
+
+        REQUIRE(m.size() == 2);
+        REQUIRE(m.at("tintin") == 1);
+        REQUIRE(m.at("milou") == 2);
+        REQUIRE(values[0].first.empty());
+    }
+
     SECTION("insert - initializer_list")
     {
         std::initializer_list<std::pair<const std::string, int>> l{{"test", 42}, {"test2", 1337}};
@@ -705,6 +950,286 @@ TEST_CASE("insert")
     }
 }
 
+TEST_CASE("insert_unique_unchecked")
+{
+    std::vector<std::pair<int, std::string>> values;
+    for (int i = 0; i < 1000; ++i)
+    {
+        values.emplace_back(i, std::to_string(i));
+    }
+
+    SECTION("constructor")
+    {
+        jg::dense_hash_map<int, std::string> m(jg::unique_keys, values.begin(), values.end());
+        REQUIRE(m.size() == 1000);
+        REQUIRE(std::equal(m.begin(), m.end(), values.begin(), values.end(), [](auto& l, auto& r) {
+            return l.first == r.first && l.second == r.second;
+        }));
+    }
+
+    SECTION("member")
+    {
+        jg::dense_hash_map<int, std::string> m = {{-1, "-1"}};
+        m.insert_unique_unchecked(
+            std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+
+        REQUIRE(m.size() == 1001);
+        REQUIRE(m.at(-1) == "-1");
+        REQUIRE(m.at(999) == "999");
+        REQUIRE(values[999].second.empty());
+
+        REQUIRE(m.erase(500) == 1);
+        REQUIRE_FALSE(m.contains(500));
+        REQUIRE(m.size() == 1000);
+    }
+}
+
+TEST_CASE("radix partitioned bulk insertion")
+{
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < 100000; ++i)
+    {
+        values.emplace_back((i * 7919) % 90000, i);
+    }
+
+    auto check_layout = [](const auto& m) {
+        // The nodes are sorted by bucket, so every chain is a contiguous run of nodes.
+        REQUIRE(std::is_sorted(m.begin(), m.end(), [&m](const auto& lhs, const auto& rhs) {
+            return m.bucket(lhs.first) < m.bucket(rhs.first);
+        }));
+    };
+
+    SECTION("checked")
+    {
+        jg::dense_hash_map<int, int> m(values.begin(), values.end());
+        REQUIRE(m.size() == 90000);
+        check_layout(m);
+
+        // The first occurrence of a key wins.
+        for (int i = 0; i < 90000; ++i)
+        {
+            REQUIRE(m.at((i * 7919) % 90000) == i);
+        }
+    }
+
+    SECTION("unique")
+    {
+        values.resize(90000);
+
+        jg::dense_hash_map<int, int> m(jg::unique_keys, values.begin(), values.end());
+        REQUIRE(m.size() == 90000);
+        check_layout(m);
+
+        for (const auto& [key, value] : values)
+        {
+            REQUIRE(m.at(key) == value);
+        }
+    }
+}
+
+TEST_CASE("parallel bulk insertion")
+{
+    std::vector<std::pair<std::string, int>> values;
+    for (int i = 0; i < 60000; ++i)
+    {
+        values.emplace_back(std::to_string((i * 7919) % 50000), i);
+    }
+
+    SECTION("checked")
+    {
+        jg::dense_hash_map<std::string, int> m(
+            jg::parallel_policy{4}, values.begin(), values.end());
+        REQUIRE(m.size() == 50000);
+
+        // The first occurrence of a key wins.
+        for (int i = 0; i < 50000; ++i)
+        {
+            REQUIRE(m.at(std::to_string((i * 7919) % 50000)) == i);
+        }
+    }
+
+    SECTION("checked - existing keys are kept")
+    {
+        jg::dense_hash_map<std::string, int> m{{"42", -1}, {"-1", -1}};
+        m.insert(jg::parallel_policy{4}, values.begin(), values.end());
+
+        REQUIRE(m.size() == 50001);
+        REQUIRE(m.at("42") == -1);
+        REQUIRE(m.at("-1") == -1);
+        REQUIRE(m.at(std::to_string(7919)) == 1);
+    }
+
+    SECTION("unique")
+    {
+        values.resize(50000);
+
+        jg::dense_hash_map<std::string, int> m(
+            jg::parallel_policy{4}, jg::unique_keys, values.begin(), values.end());
+        REQUIRE(m.size() == 50000);
+
+        for (const auto& [key, value] : values)
+        {
+            REQUIRE(m.at(key) == value);
+        }
+    }
+
+    SECTION("small ranges and other iterators")
+    {
+        jg::dense_hash_map<std::string, int> m(
+            jg::parallel_policy{4}, values.begin(), values.begin() + 10);
+        REQUIRE(m.size() == 10);
+
+        std::list<std::pair<std::string, int>> list(values.begin(), values.begin() + 10);
+        m.insert(jg::parallel_policy{}, list.begin(), list.end());
+        REQUIRE(m.size() == 10);
+    }
+}
+
+TEST_CASE("parallel rehash")
+{
+    jg::dense_hash_map<int, int> m;
+    for (int i = 0; i < 50000; ++i)
+    {
+        m.emplace(i * 3, i);
+    }
+
+    auto serial = m;
+
+    auto require_same_chains = [](const auto& lhs, const auto& rhs) {
+        REQUIRE(lhs.bucket_count() == rhs.bucket_count());
+
+        bool same_chains = true;
+        for (std::size_t n = 0; n < lhs.bucket_count(); ++n)
+        {
+            same_chains &= std::equal(lhs.begin(n), lhs.end(n), rhs.begin(n), rhs.end(n));
+        }
+
+        REQUIRE(same_chains);
+    };
+
+    SECTION("rehash")
+    {
+        m.rehash(jg::parallel_policy{4}, 1u << 18);
+        serial.rehash(1u << 18);
+        require_same_chains(m, serial);
+
+        m.rehash(jg::parallel_policy{4}, 0u);
+        serial.rehash(0u);
+        require_same_chains(m, serial);
+    }
+
+    SECTION("reserve")
+    {
+        m.reserve(jg::parallel_policy{}, 200000);
+        serial.reserve(200000);
+        require_same_chains(m, serial);
+
+        for (int i = 0; i < 50000; ++i)
+        {
+            REQUIRE(m.at(i * 3) == i);
+        }
+    }
+
+    SECTION("rehash - after erasures, with back links")
+    {
+        erase_policy_map<int, int, jg::details::back_link_erase_policy> links;
+        for (int i = 0; i < 50000; ++i)
+        {
+            links.emplace(i * 3, i);
+        }
+
+        // The swaps with the last node leave chains whose nodes are not in order.
+        for (int i = 0; i < 50000; i += 7)
+        {
+            links.erase(i * 3);
+        }
+
+        auto serial_links = links;
+        links.rehash(jg::parallel_policy{4}, 1u << 18);
+        serial_links.rehash(1u << 18);
+        REQUIRE(links.bucket_count() == serial_links.bucket_count());
+
+        bool same_buckets = true;
+        for (std::size_t n = 0; n < links.bucket_count(); ++n)
+        {
+            same_buckets &= links.bucket_size(n) == serial_links.bucket_size(n) &&
+                            std::all_of(links.begin(n), links.end(n), [&](const auto& pair) {
+                                return serial_links.bucket(pair.first) == n;
+                            });
+        }
+
+        REQUIRE(same_buckets);
+
+        // The back links are walked by the erasures.
+        for (int i = 1; i < 50000; i += 7)
+        {
+            REQUIRE(links.erase(i * 3) == 1);
+        }
+
+        for (int i = 0; i < 50000; ++i)
+        {
+            REQUIRE(links.count(i * 3) == (i % 7 > 1 ? 1u : 0u));
+        }
+    }
+}
+
+TEST_CASE("parallel algorithms")
+{
+    jg::dense_hash_map<int, std::int64_t> m;
+    for (int i = 0; i < 100000; ++i)
+    {
+        m.emplace(i, i);
+    }
+
+    SECTION("for_each")
+    {
+        m.for_each(jg::parallel_policy{4}, [](auto& pair) { pair.second *= 2; });
+
+        std::atomic<std::int64_t> sum{0};
+        std::as_const(m).for_each(
+            jg::parallel_policy{4}, [&sum](const auto& pair) { sum += pair.second; });
+        REQUIRE(sum == std::int64_t{99999} * 100000);
+    }
+
+    SECTION("transform_values")
+    {
+        m.transform_values(
+            jg::parallel_policy{4}, [](const auto& pair) { return pair.first + pair.second; });
+
+        for (const auto& [key, value] : m)
+        {
+            REQUIRE(value == 2 * key);
+        }
+    }
+
+    SECTION("reduce")
+    {
+        const auto sum = m.reduce(
+            jg::parallel_policy{4}, std::int64_t{1}, std::plus<>{},
+            [](const auto& pair) { return pair.second; });
+        REQUIRE(sum == std::int64_t{99999} * 50000 + 1);
+
+        const jg::dense_hash_map<int, std::int64_t> empty;
+        REQUIRE(empty.reduce(jg::parallel_policy{}, 42, std::plus<>{}, [](const auto&) {
+            return 1;
+        }) == 42);
+    }
+
+    SECTION("exceptions")
+    {
+        REQUIRE_THROWS_AS(
+            m.for_each(
+                jg::parallel_policy{4},
+                [](const auto& pair) {
+                    if (pair.first == 77777)
+                    {
+                        throw std::runtime_error("error");
+                    }
+                }),
+            std::runtime_error);
+    }
+}
+
 TEST_CASE("insert_or_assign")
 {
     jg::dense_hash_map<std::string, int> m1;
@@ -1332,6 +1857,24 @@ TEST_CASE("rehash")
         REQUIRE(it->second == 1337);
     }
 
+    SECTION("integral keys")
+    {
+        jg::dense_hash_map<std::uint64_t, int> im;
+
+        for (int i = 0; i < 10000; ++i)
+        {
+            im.try_emplace(static_cast<std::uint64_t>(i) * 4096u, i);
+        }
+
+        im.rehash(1u << 16);
+        REQUIRE(im.bucket_count() == 1u << 16);
+
+        for (int i = 0; i < 10000; ++i)
+        {
+            REQUIRE(im.at(static_cast<std::uint64_t>(i) * 4096u) == i);
+        }
+    }
+
     SECTION("reserve")
     {
         m.try_emplace("tarzan", 42);
@@ -1659,9 +2202,116 @@ TEST_CASE("contains transparent hash", "[contains]")
     }
 }
 
-TEST_CASE("equal_range simple hash", "[equal_range]")
+TEST_CASE("find_many", "[find]")
 {
-    jg::dense_hash_map<std::string, int> m1 = {};
+    jg::dense_hash_map<int, int> m;
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        m.try_emplace(i, i * 10);
+    }
+
+    std::vector<int> keys;
+    for (int i = 0; i < 100; ++i)
+    {
+        keys.push_back((i * 37) % 1200);
+    }
+
+    SECTION("non-const")
+    {
+        std::vector<decltype(m)::iterator> results;
+        m.find_many(keys.begin(), keys.end(), std::back_inserter(results));
+
+        REQUIRE(results.size() == keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(results[i] == m.find(keys[i]));
+        }
+    }
+
+    SECTION("const")
+    {
+        const auto& cm = m;
+        std::vector<decltype(m)::const_iterator> results(keys.size());
+        auto out = cm.find_many(keys.begin(), keys.end(), results.begin());
+
+        REQUIRE(out == results.end());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(results[i] == cm.find(keys[i]));
+        }
+    }
+
+    SECTION("contains_many")
+    {
+        std::vector<bool> results;
+        m.contains_many(keys.begin(), keys.end(), std::back_inserter(results));
+
+        REQUIRE(results.size() == keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(results[i] == m.contains(keys[i]));
+        }
+    }
+
+    SECTION("collisions")
+    {
+        jg::dense_hash_map<std::string, int, collision_hasher> cm = {
+            {"tintin", 1}, {"milou", 2}, {"haddock", 3}};
+        const std::vector<std::string> ckeys = {"milou", "dupont", "tintin", "haddock"};
+
+        std::vector<bool> results;
+        cm.contains_many(ckeys.begin(), ckeys.end(), std::back_inserter(results));
+        REQUIRE(results == std::vector<bool>{true, false, true, true});
+    }
+}
+
+TEST_CASE("pre-hashed lookups", "[find]")
+{
+    jg::dense_hash_map<std::string, int> shard1 = {{"tintin", 1}, {"milou", 2}};
+    jg::dense_hash_map<std::string, int> shard2(64u);
+    shard2.try_emplace("haddock", 3);
+
+    const std::string key = "milou";
+    const auto hash = shard1.hash_key(key);
+    REQUIRE(hash.value == std::hash<std::string>{}(key));
+
+    shard1.prefetch(hash);
+    shard2.prefetch(hash);
+
+    SECTION("find / contains")
+    {
+        REQUIRE(shard1.find(key, hash) == shard1.find(key));
+        REQUIRE(shard1.contains(key, hash));
+        REQUIRE(std::as_const(shard1).find(key, hash)->second == 2);
+        REQUIRE(shard2.find(key, hash) == shard2.end());
+        REQUIRE_FALSE(shard2.contains(key, hash));
+    }
+
+    SECTION("try_emplace")
+    {
+        const auto [it, inserted] = shard2.try_emplace(key, hash, 42);
+        REQUIRE(inserted);
+        REQUIRE(it->second == 42);
+        REQUIRE(shard2.at(key) == 42);
+
+        const auto [it2, inserted2] = shard1.try_emplace(std::string(key), hash, 42);
+        REQUIRE_FALSE(inserted2);
+        REQUIRE(it2->second == 2);
+    }
+
+    SECTION("erase")
+    {
+        REQUIRE(shard2.erase(key, hash) == 0);
+        REQUIRE(shard1.erase(key, hash) == 1);
+        REQUIRE_FALSE(shard1.contains(key));
+        REQUIRE(shard1.size() == 1);
+    }
+}
+
+TEST_CASE("equal_range simple hash", "[equal_range]")
+{
+    jg::dense_hash_map<std::string, int> m1 = {};
 
     SECTION("non-const")
     {
@@ -1865,6 +2515,164 @@ TEST_CASE("erase_if")
     }
 }
 
+TEST_CASE("back-linked erase")
+{
+    SECTION("erasing by iterator does not hash")
+    {
+        int hash_count = 0;
+        erase_policy_map<std::string, int, jg::details::back_link_erase_policy, counting_hash> m(
+            8u, counting_hash{&hash_count});
+
+        for (int i = 0; i < 100; ++i)
+        {
+            m.emplace(std::to_string(i), i);
+        }
+
+        hash_count = 0;
+        auto it = m.erase(m.begin());
+        REQUIRE(it == m.begin());
+        REQUIRE(it->first == "99");
+        m.erase(std::next(m.begin(), 50));
+        m.erase(std::prev(m.end()));
+        REQUIRE(hash_count == 0);
+
+        REQUIRE(m.size() == 97);
+        REQUIRE(!m.contains("0"));
+    }
+
+    SECTION("relocatable values")
+    {
+        random_erase_workload(
+            erase_policy_map<std::string, int, jg::details::back_link_erase_policy>{},
+            [](int i) { return i; }, 42u);
+    }
+
+    SECTION("move-assigned values and collisions")
+    {
+        random_erase_workload(
+            erase_policy_map<
+                std::string, std::unique_ptr<int>, jg::details::back_link_erase_policy,
+                collision_hasher>{},
+            [](int i) { return std::make_unique<int>(i); }, 42u);
+    }
+}
+
+TEST_CASE("erase_many")
+{
+    jg::dense_hash_map<std::string, int> m;
+    for (int i = 0; i < 1000; ++i)
+    {
+        m.emplace(std::to_string(i), i);
+    }
+
+    auto check = [&m](const std::vector<std::string>& erased) {
+        for (int i = 0; i < 1000; ++i)
+        {
+            const auto key = std::to_string(i);
+            const auto it = m.find(key);
+            const bool is_erased = std::find(erased.begin(), erased.end(), key) != erased.end();
+
+            REQUIRE((it == m.end()) == is_erased);
+            REQUIRE((it == m.end() || it->second == i));
+        }
+    };
+
+    SECTION("few keys")
+    {
+        const std::vector<std::string> keys = {"999", "3", "foo", "500", "3", "0", "998"};
+        REQUIRE(m.erase_many(keys.begin(), keys.end()) == 5);
+        REQUIRE(m.size() == 995);
+        check(keys);
+    }
+
+    SECTION("many keys")
+    {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; i += 2)
+        {
+            keys.push_back(std::to_string(i));
+        }
+        keys.push_back("bar");
+
+        REQUIRE(m.erase_many(keys.begin(), keys.end()) == 500);
+        REQUIRE(m.size() == 500);
+        check(keys);
+    }
+
+    SECTION("no keys")
+    {
+        const std::vector<std::string> keys;
+        REQUIRE(m.erase_many(keys.begin(), keys.end()) == 0);
+        REQUIRE(m.size() == 1000);
+    }
+}
+
+TEST_CASE("erase_if member")
+{
+    jg::dense_hash_map<std::string, int> m;
+    for (int i = 0; i < 50000; ++i)
+    {
+        m.emplace(std::to_string(i), i);
+    }
+
+    auto check = [](const auto& m, int divisor) {
+        REQUIRE(m.size() == static_cast<std::size_t>(50000 - (50000 + divisor - 1) / divisor));
+
+        // The kept elements stay in insertion order.
+        REQUIRE(std::is_sorted(m.begin(), m.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second < rhs.second;
+        }));
+
+        for (int i = 0; i < 50000; ++i)
+        {
+            REQUIRE(m.contains(std::to_string(i)) == (i % divisor != 0));
+        }
+    };
+
+    SECTION("serial")
+    {
+        REQUIRE(m.erase_if([](const auto& pair) { return pair.second % 5 == 0; }) == 10000);
+        check(m, 5);
+
+        REQUIRE(m.erase_if([](const auto&) { return false; }) == 0);
+        check(m, 5);
+    }
+
+    SECTION("parallel")
+    {
+        const auto erased_count = m.erase_if(
+            jg::parallel_policy{4}, [](const auto& pair) { return pair.second % 3 == 0; });
+        REQUIRE(erased_count == 16667);
+        check(m, 3);
+    }
+
+    SECTION("throwing predicate")
+    {
+        int calls = 0;
+        const auto pred = [&calls](const auto& pair) {
+            if (++calls == 30000)
+            {
+                throw std::runtime_error("predicate");
+            }
+            return pair.second % 2 == 0;
+        };
+
+        REQUIRE_THROWS_AS(m.erase_if(pred), std::runtime_error);
+        REQUIRE(m.size() == 50000);
+        for (int i = 0; i < 50000; ++i)
+        {
+            REQUIRE(m.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("everything")
+    {
+        REQUIRE(m.erase_if([](const auto&) { return true; }) == 50000);
+        REQUIRE(m.empty());
+        REQUIRE(m.find("0") == m.end());
+    }
+}
+
 TEST_CASE("deduction guides")
 {
     jg::dense_hash_map<std::string, int> m;
@@ -2064,3 +2872,997 @@ TEST_CASE("growth policy")
     m.rehash(500);
     REQUIRE(m.bucket_count() == 500);
 }
+
+TEST_CASE("nodes container policy")
+{
+    jg::dense_hash_map<
+        std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+        std::allocator<std::pair<const std::string, int>>, jg::details::power_of_two_growth_policy,
+        derived_vector_policy>
+        m{};
+
+    for (int i = 0; i < 100; ++i)
+    {
+        m.try_emplace(std::to_string(i), i);
+    }
+
+    REQUIRE(m.size() == 100);
+    REQUIRE(m["42"] == 42);
+
+    m.erase("42");
+    REQUIRE_FALSE(m.contains("42"));
+    REQUIRE(m.size() == 99);
+
+    auto m2 = m;
+    REQUIRE(m2 == m);
+    REQUIRE(std::distance(m2.begin(), m2.end()) == 99);
+}
+
+TEST_CASE("segmented nodes container")
+{
+    using segmented_map = jg::dense_hash_map<
+        std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+        std::allocator<std::pair<const std::string, int>>, jg::details::power_of_two_growth_policy,
+        jg::details::segmented_nodes_container_policy<4u>>;
+
+    segmented_map m;
+
+    SECTION("growth does not move nodes")
+    {
+        m.try_emplace("first", 1);
+        const auto* first_value = &m.find("first")->second;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            m.try_emplace(std::to_string(i), i);
+        }
+
+        REQUIRE(m.size() == 1001);
+        REQUIRE(&m.find("first")->second == first_value);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            REQUIRE(m.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("erase, copy and move")
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            m.try_emplace(std::to_string(i), i);
+        }
+
+        for (int i = 0; i < 100; i += 2)
+        {
+            REQUIRE(m.erase(std::to_string(i)) == 1);
+        }
+
+        REQUIRE(m.size() == 50);
+        REQUIRE(std::distance(m.begin(), m.end()) == 50);
+        REQUIRE(std::all_of(m.begin(), m.end(), [](const auto& p) { return p.second % 2 == 1; }));
+
+        auto m2 = m;
+        REQUIRE(m2 == m);
+
+        auto m3 = std::move(m2);
+        REQUIRE(m3 == m);
+
+        m3.clear();
+        REQUIRE(m3.empty());
+        m3 = m;
+        REQUIRE(m3 == m);
+    }
+
+    SECTION("allocator propagation")
+    {
+        int counter = 0;
+        auto r = counting_pmr_resource(&counter);
+
+        jg::pmr::dense_hash_map<
+            std::pmr::string, int, std::hash<std::pmr::string>, std::equal_to<std::pmr::string>,
+            jg::details::power_of_two_growth_policy,
+            jg::details::segmented_nodes_container_policy<4u>>
+            pm(8u, &r);
+
+        pm.try_emplace("a_super_long_string_to_disable_short_string_optimization", 1);
+        REQUIRE(pm.begin()->first.get_allocator().resource() == &r);
+    }
+}
+
+TEST_CASE("trivially relocatable")
+{
+    std::size_t counter = 0;
+    jg::dense_hash_map<int, increase_counter_on_copy_or_move> m;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        m.try_emplace(i, &counter);
+    }
+
+    counter = 0;
+
+    SECTION("erase relocates the last node")
+    {
+        for (int i = 0; i < 100; i += 2)
+        {
+            REQUIRE(m.erase(i) == 1);
+        }
+
+        REQUIRE(counter == 0);
+        REQUIRE(m.size() == 50);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(m.contains(i) == (i % 2 == 1));
+        }
+    }
+
+    SECTION("bitwise copy of the segments")
+    {
+        jg::dense_hash_map<
+            int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+            jg::details::power_of_two_growth_policy,
+            jg::details::segmented_nodes_container_policy<8u>>
+            m1;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            m1.try_emplace(i, i * 2);
+        }
+
+        auto m2 = m1;
+        REQUIRE(m2 == m1);
+        m2.erase(10);
+        REQUIRE(m2.size() == 99);
+        REQUIRE(m2.at(99) == 198);
+    }
+}
+
+TEST_CASE("shrink_to_fit")
+{
+    auto fill_and_shrink = [](auto& m) {
+        for (int i = 0; i < 1000; ++i)
+        {
+            m.try_emplace(i, i);
+        }
+
+        std::erase_if(m, [](const auto& p) { return p.first >= 10; });
+        REQUIRE(m.size() == 10);
+        REQUIRE(m.bucket_count() >= 1024);
+
+        m.shrink_to_fit();
+        REQUIRE(m.bucket_count() == 16);
+        REQUIRE(m.size() == 10);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(m.at(i) == i);
+        }
+
+        m.try_emplace(42, 42);
+        REQUIRE(m.at(42) == 42);
+    };
+
+    SECTION("vector")
+    {
+        jg::dense_hash_map<int, int> m;
+        fill_and_shrink(m);
+    }
+
+    SECTION("segmented")
+    {
+        jg::dense_hash_map<
+            int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+            jg::details::power_of_two_growth_policy,
+            jg::details::segmented_nodes_container_policy<8u>>
+            m;
+        fill_and_shrink(m);
+    }
+}
+
+TEST_CASE("tombstone erase")
+{
+    using tombstone_map = erase_policy_map<std::string, int, jg::details::tombstone_erase_policy>;
+
+    tombstone_map m;
+    for (int i = 0; i < 100; ++i)
+    {
+        m.emplace(std::to_string(i), i);
+    }
+
+    // Moving by n elements would have to skip the dead nodes one by one.
+    static_assert(
+        !jg::details::is_detected<detect_iterator_advance, tombstone_map::iterator>::value);
+    static_assert(
+        !jg::details::is_detected<detect_iterator_distance, tombstone_map::const_iterator>::value);
+    static_assert(jg::details::is_detected<
+                  detect_iterator_distance, jg::dense_hash_map<int, int>::iterator>::value);
+
+    SECTION("erasing keeps the other iterators valid")
+    {
+        const auto it_10 = m.find("10");
+        const auto it_50 = m.find("50");
+
+        for (int i = 0; i < 100; i += 2)
+        {
+            if (i != 10 && i != 50)
+            {
+                REQUIRE(m.erase(std::to_string(i)) == 1);
+            }
+        }
+
+        REQUIRE(m.size() == 52);
+        REQUIRE(it_10->second == 10);
+        REQUIRE(it_50->second == 50);
+        REQUIRE(m.find("10") == it_10);
+        REQUIRE(!m.contains("20"));
+
+        std::vector<int> expected;
+        for (int i = 0; i < 100; ++i)
+        {
+            if (i % 2 == 1 || i == 10 || i == 50)
+            {
+                expected.push_back(i);
+            }
+        }
+
+        std::vector<int> values;
+        for (const auto& [key, value] : m)
+        {
+            values.push_back(value);
+        }
+        REQUIRE(values == expected);
+    }
+
+    SECTION("erasing while iterating")
+    {
+        for (auto it = m.begin(); it != m.end();)
+        {
+            it = it->second % 3 == 0 ? m.erase(it) : std::next(it);
+        }
+
+        REQUIRE(m.size() == 66);
+        for (const auto& [key, value] : m)
+        {
+            REQUIRE(value % 3 != 0);
+        }
+
+        m.erase(m.begin(), m.end());
+        REQUIRE(m.empty());
+        REQUIRE(m.begin() == m.end());
+    }
+
+    SECTION("erasing the first and the last elements")
+    {
+        m.erase("0");
+        REQUIRE(m.begin()->second == 1);
+
+        m.erase("98");
+        m.erase("99");
+        REQUIRE(std::prev(m.end())->second == 97);
+        REQUIRE(m.size() == 97);
+    }
+
+    SECTION("erasing the last elements keeps the other iterators valid")
+    {
+        auto it = m.find("97");
+        const auto end = m.end();
+
+        m.erase("98");
+        m.erase("99");
+        REQUIRE(m.end() == end);
+        REQUIRE(++it == m.end());
+        REQUIRE(std::prev(it)->second == 97);
+    }
+
+    SECTION("erasing everything through begin")
+    {
+        for (int i = 100; i < 100000; ++i)
+        {
+            m.emplace(std::to_string(i), i);
+        }
+
+        int expected = 0;
+        while (!m.empty())
+        {
+            REQUIRE(m.begin()->second == expected++);
+            m.erase(m.begin());
+        }
+
+        REQUIRE(expected == 100000);
+        REQUIRE(m.begin() == m.end());
+    }
+
+    SECTION("erasing most elements destroys their values")
+    {
+        const auto token = std::make_shared<int>(0);
+        erase_policy_map<int, std::shared_ptr<int>, jg::details::tombstone_erase_policy> tokens;
+        for (int i = 0; i < 100; ++i)
+        {
+            tokens.emplace(i, token);
+        }
+
+        for (int i = 0; i < 60; ++i)
+        {
+            tokens.erase(i);
+        }
+
+        // No more dead values are kept than live ones.
+        REQUIRE(token.use_count() <= 1 + 40 + 40);
+        REQUIRE(tokens.begin()->first == 60);
+    }
+
+    SECTION("inserting a copy of an element while compacting or rehashing")
+    {
+        erase_policy_map<int, std::string, jg::details::tombstone_erase_policy> strings;
+        for (int i = 0; i < 16; ++i)
+        {
+            strings.emplace(i, std::to_string(i));
+        }
+        for (int i = 0; i < 12; ++i)
+        {
+            strings.erase(i);
+        }
+
+        REQUIRE(strings.emplace(100, strings.at(15)).first->second == "15");
+
+        for (int i = 101; i < 2000; ++i)
+        {
+            strings.emplace(i, strings.at(i - 1));
+            if (i % 2 == 0)
+            {
+                strings.erase(i - 1);
+            }
+        }
+
+        REQUIRE(strings.size() == 955u);
+        for (const auto& [key, value] : strings)
+        {
+            REQUIRE(value == std::to_string(key < 16 ? key : 15));
+        }
+    }
+
+    SECTION("compaction keeps the order")
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            if (i % 4 != 0)
+            {
+                m.erase(std::to_string(i));
+            }
+        }
+
+        m.compact();
+        REQUIRE(m.size() == 25);
+        REQUIRE(std::distance(m.begin(), m.end()) == 25);
+
+        int expected = 0;
+        for (const auto& [key, value] : m)
+        {
+            REQUIRE(value == expected);
+            REQUIRE(m.at(key) == expected);
+            expected += 4;
+        }
+
+        m.try_emplace("foo", 42);
+        REQUIRE(m.size() == 26);
+        REQUIRE(std::prev(m.end())->second == 42);
+    }
+
+    SECTION("insertion compacts the mostly dead nodes")
+    {
+        for (int i = 0; i < 80; ++i)
+        {
+            m.erase(std::to_string(i));
+        }
+
+        for (int i = 100; i < 200; ++i)
+        {
+            m.emplace(std::to_string(i), i);
+        }
+
+        REQUIRE(m.size() == 120);
+        for (int i = 80; i < 200; ++i)
+        {
+            REQUIRE(m.at(std::to_string(i)) == i);
+        }
+        REQUIRE(std::distance(m.begin(), m.end()) == 120);
+    }
+
+    SECTION("rehash and erase_if")
+    {
+        for (int i = 0; i < 100; i += 3)
+        {
+            m.erase(std::to_string(i));
+        }
+
+        REQUIRE(m.erase_if([](const auto& pair) { return pair.second % 3 == 1; }) == 33);
+        m.rehash(1024u);
+        REQUIRE(m.size() == 33);
+        for (const auto& [key, value] : m)
+        {
+            REQUIRE(value % 3 == 2);
+            REQUIRE(m.at(key) == value);
+        }
+    }
+
+    SECTION("random workload")
+    {
+        random_erase_workload(
+            erase_policy_map<std::string, int, jg::details::tombstone_erase_policy>{},
+            [](int i) { return i; }, 7u);
+    }
+
+    SECTION("random workload with back links")
+    {
+        random_erase_workload(
+            erase_policy_map<
+                std::string, int, back_linked_tombstone_erase_policy, collision_hasher>{},
+            [](int i) { return i; }, 7u);
+    }
+}
+
+TEST_CASE("stable handles")
+{
+    using handle_map = erase_policy_map<std::string, int, jg::details::stable_handle_erase_policy>;
+
+    handle_map m;
+    std::vector<handle_map::handle_type> handles;
+    for (int i = 0; i < 100; ++i)
+    {
+        const auto [it, inserted] = m.emplace(std::to_string(i), i);
+        handles.push_back(m.handle_of(it));
+    }
+
+    auto check_handles = [&m, &handles](auto is_erased) {
+        bool valid = true;
+        for (int i = 0; i < 100; ++i)
+        {
+            const auto it = m.resolve(handles[i]);
+            valid = valid && (is_erased(i) ? it == m.end() : it->second == i);
+        }
+        REQUIRE(valid);
+    };
+
+    SECTION("erasing moves the last node but keeps the handles")
+    {
+        for (int i = 0; i < 100; i += 3)
+        {
+            m.erase(std::to_string(i));
+        }
+
+        check_handles([](int i) { return i % 3 == 0; });
+    }
+
+    SECTION("rehashing keeps the handles")
+    {
+        m.rehash(4096u);
+        check_handles([](int /*i*/) { return false; });
+        REQUIRE(m.handle_of(m.find("42")) == handles[42]);
+    }
+
+    SECTION("erase_if keeps the handles")
+    {
+        REQUIRE(m.erase_if([](const auto& pair) { return pair.second % 2 == 1; }) == 50);
+        check_handles([](int i) { return i % 2 == 1; });
+    }
+
+    SECTION("reused slots do not resurrect stale handles")
+    {
+        m.erase("7");
+        const auto [it, inserted] = m.emplace("foo", 42);
+        const auto handle = m.handle_of(it);
+
+        REQUIRE(handle.slot == handles[7].slot);
+        REQUIRE(handle != handles[7]);
+        REQUIRE(m.resolve(handles[7]) == m.end());
+        REQUIRE(m.resolve(handle)->second == 42);
+    }
+
+    SECTION("clear invalidates every handle")
+    {
+        m.clear();
+        m.emplace("0", 0);
+        check_handles([](int /*i*/) { return true; });
+        REQUIRE(m.resolve(handle_map::handle_type{}) == m.end());
+    }
+
+    SECTION("copies share the handles")
+    {
+        const auto copy = m;
+        m.erase("5");
+        REQUIRE(copy.resolve(handles[5])->second == 5);
+        REQUIRE(m.resolve(handles[5]) == m.end());
+    }
+
+    SECTION("merging does not resurrect stale handles")
+    {
+        handle_map target;
+        const auto stale = target.handle_of(target.emplace("x", 1).first);
+        target.erase("x");
+
+        handle_map source;
+        source.emplace("e", 2);
+        target.merge(source);
+
+        REQUIRE(source.empty());
+        REQUIRE(target.resolve(stale) == target.end());
+        REQUIRE(target.resolve(target.handle_of(target.find("e")))->second == 2);
+    }
+
+    SECTION("random workload")
+    {
+        std::unordered_map<std::string, handle_map::handle_type> expected;
+        for (int i = 0; i < 100; ++i)
+        {
+            expected.emplace(std::to_string(i), handles[i]);
+        }
+
+        lcg_random next_random{13u};
+
+        for (int i = 0; i < 20000; ++i)
+        {
+            const auto key = std::to_string(next_random() % 400);
+
+            if (next_random() % 2 == 0)
+            {
+                const auto found = expected.find(key);
+                if (found != expected.end())
+                {
+                    m.erase(m.resolve(found->second));
+                    expected.erase(found);
+                }
+            }
+            else if (const auto [it, inserted] = m.try_emplace(key, i); inserted)
+            {
+                expected.emplace(key, m.handle_of(it));
+            }
+        }
+
+        REQUIRE(m.size() == expected.size());
+        bool valid = true;
+        for (const auto& [key, handle] : expected)
+        {
+            valid = valid && m.resolve(handle)->first == key;
+        }
+        REQUIRE(valid);
+    }
+}
+
+TEST_CASE("insertion order")
+{
+    auto keys_of = [](const auto& m) {
+        std::vector<int> keys;
+        for (const auto& [key, value] : m)
+        {
+            keys.push_back(key);
+        }
+        return keys;
+    };
+
+    SECTION("erasing and inserting")
+    {
+        jg::ordered_dense_hash_map<int, int> m;
+        std::vector<int> expected;
+        lcg_random next_random{3u};
+
+        for (int i = 0; i < 20000; ++i)
+        {
+            const auto key = static_cast<int>(next_random() % 1000);
+            const auto found = std::find(expected.begin(), expected.end(), key);
+
+            if (next_random() % 3 == 0)
+            {
+                REQUIRE(m.erase(key) == (found != expected.end() ? 1u : 0u));
+                if (found != expected.end())
+                {
+                    expected.erase(found);
+                }
+            }
+            else
+            {
+                m.insert_or_assign(key, i);
+                if (found == expected.end())
+                {
+                    expected.push_back(key);
+                }
+            }
+        }
+
+        REQUIRE(m.size() == expected.size());
+        REQUIRE(keys_of(m) == expected);
+
+        m.rehash(8192u);
+        REQUIRE(keys_of(m) == expected);
+
+        m.erase_if([](const auto& pair) { return pair.first % 2 == 0; });
+        expected.erase(
+            std::remove_if(expected.begin(), expected.end(), [](int key) { return key % 2 == 0; }),
+            expected.end());
+        REQUIRE(keys_of(m) == expected);
+    }
+
+    SECTION("bulk insertions keep the order of the range")
+    {
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<int> expected;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const auto key = (i * 7919) % 90001;
+            pairs.emplace_back(key, i);
+            if (i < 90001)
+            {
+                expected.push_back(key);
+            }
+        }
+
+        jg::ordered_dense_hash_map<int, int> m(pairs.begin(), pairs.end());
+        REQUIRE(keys_of(m) == expected);
+
+        jg::ordered_dense_hash_map<int, int> pm;
+        pm.insert(jg::parallel_policy{4}, pairs.begin(), pairs.end());
+        REQUIRE(keys_of(pm) == expected);
+    }
+}
+
+TEST_CASE("node handles")
+{
+    jg::dense_hash_map<std::string, std::unique_ptr<int>> m;
+    for (int i = 0; i < 10; ++i)
+    {
+        m.emplace(std::to_string(i), std::make_unique<int>(i));
+    }
+
+    SECTION("extract and insert")
+    {
+        auto node = m.extract("3");
+        REQUIRE(!node.empty());
+        REQUIRE(node.key() == "3");
+        REQUIRE(*node.mapped() == 3);
+        REQUIRE(m.size() == 9);
+        REQUIRE(!m.contains("3"));
+
+        node.key() = "foo";
+
+        jg::dense_hash_map<std::string, std::unique_ptr<int>> other;
+        const auto result = other.insert(std::move(node));
+        REQUIRE(result.inserted);
+        REQUIRE(result.node.empty());
+        REQUIRE(node.empty());
+        REQUIRE(result.position->first == "foo");
+        REQUIRE(*other.at("foo") == 3);
+
+        auto empty_node = m.extract("bar");
+        REQUIRE(!empty_node);
+        REQUIRE(!m.insert(std::move(empty_node)).inserted);
+        REQUIRE(m.size() == 9);
+    }
+
+    SECTION("inserting an existing key hands the node back")
+    {
+        auto node = m.extract(m.find("5"));
+        m.emplace("5", std::make_unique<int>(42));
+
+        auto result = m.insert(std::move(node));
+        REQUIRE(!result.inserted);
+        REQUIRE(result.node.key() == "5");
+        REQUIRE(*result.node.mapped() == 5);
+        REQUIRE(*result.position->second == 42);
+    }
+
+    SECTION("extracting every element")
+    {
+        std::vector<decltype(m)::node_type> nodes;
+        while (!m.empty())
+        {
+            nodes.push_back(m.extract(m.begin()));
+        }
+
+        for (auto& node : nodes)
+        {
+            const auto key = node.key();
+            REQUIRE(m.insert(m.end(), std::move(node))->first == key);
+        }
+
+        REQUIRE(m.size() == 10);
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(*m.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("merge with overlapping keys")
+    {
+        jg::dense_hash_map<std::string, std::unique_ptr<int>> target;
+        target.emplace("0", std::make_unique<int>(-1));
+        target.emplace("foo", std::make_unique<int>(-2));
+
+        target.merge(m);
+        REQUIRE(target.size() == 11);
+        REQUIRE(m.size() == 1);
+        REQUIRE(*m.at("0") == 0);
+        REQUIRE(*target.at("0") == -1);
+        for (int i = 1; i < 10; ++i)
+        {
+            REQUIRE(*target.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("merge into an empty map takes the nodes over")
+    {
+        const auto* first_value = m.begin()->second.get();
+
+        decltype(m) target;
+        target.merge(std::move(m));
+        REQUIRE(m.empty());
+        REQUIRE(target.size() == 10);
+        REQUIRE(target.begin()->second.get() == first_value);
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(*target.at(std::to_string(i)) == i);
+        }
+
+        target.merge(target);
+        REQUIRE(target.size() == 10);
+    }
+
+    SECTION("merge from another hasher and a tombstone map")
+    {
+        jg::dense_hash_map<std::string, std::unique_ptr<int>, collision_hasher> colliding;
+        colliding.merge(m);
+        REQUIRE(m.empty());
+        REQUIRE(colliding.size() == 10);
+
+        jg::ordered_dense_hash_map<std::string, std::unique_ptr<int>> ordered;
+        for (int i = 10; i < 20; ++i)
+        {
+            ordered.emplace(std::to_string(i), std::make_unique<int>(i));
+        }
+        ordered.erase("15");
+
+        jg::ordered_dense_hash_map<std::string, std::unique_ptr<int>> target;
+        target.emplace("12", nullptr);
+        target.merge(ordered);
+        REQUIRE(target.size() == 9);
+        REQUIRE(ordered.size() == 1);
+        REQUIRE(ordered.begin()->first == "12");
+        REQUIRE(std::next(target.begin())->first == "10");
+    }
+}
+
+TEST_CASE("emplace hits")
+{
+    int hash_count = 0;
+    jg::dense_hash_map<std::string, construction_counter, counting_hash> m(
+        8u, counting_hash{&hash_count});
+
+    int construction_count = 0;
+    int i = 0;
+    while (m.size() + 1 <= m.bucket_count() * m.max_load_factor())
+    {
+        m.try_emplace(std::to_string(i++), &construction_count);
+    }
+
+    const auto bucket_count = m.bucket_count();
+    const auto size = m.size();
+    hash_count = 0;
+    construction_count = 0;
+
+    SECTION("a hit neither constructs nor grows")
+    {
+        const std::string key = "0";
+        REQUIRE(!m.try_emplace(key, &construction_count).second);
+        REQUIRE(!m.emplace(
+                      std::piecewise_construct, std::forward_as_tuple(key),
+                      std::forward_as_tuple(&construction_count))
+                     .second);
+        REQUIRE(!m.emplace(
+                      std::piecewise_construct, std::forward_as_tuple("1"),
+                      std::forward_as_tuple(&construction_count))
+                     .second);
+
+        REQUIRE(construction_count == 0);
+        REQUIRE(hash_count == 3);
+        REQUIRE(m.bucket_count() == bucket_count);
+        REQUIRE(m.size() == size);
+    }
+
+    SECTION("a miss grows")
+    {
+        REQUIRE(m.try_emplace("foo", &construction_count).second);
+        REQUIRE(construction_count == 1);
+        REQUIRE(m.bucket_count() > bucket_count);
+        REQUIRE(m.contains("foo"));
+    }
+
+    SECTION("transparent keys are converted on a miss only")
+    {
+        jg::dense_hash_map<std::string, int, string_view_hash> sm;
+        REQUIRE(sm.emplace(std::string_view{"foo"}, 1).second);
+        REQUIRE(!sm.emplace(std::string_view{"foo"}, 2).second);
+        REQUIRE(!sm.emplace(std::pair{std::string_view{"foo"}, 3}).second);
+        REQUIRE(sm.emplace(
+                      std::piecewise_construct, std::forward_as_tuple(std::string_view{"bar"}),
+                      std::forward_as_tuple(4))
+                    .second);
+        REQUIRE(sm.size() == 2);
+        REQUIRE(sm.at("foo") == 1);
+        REQUIRE(sm.at("bar") == 4);
+    }
+}
+
+TEST_CASE("heterogeneous API")
+{
+    jg::dense_hash_map<counted_key, int, counted_key_hash, std::equal_to<>> m;
+    using namespace std::string_view_literals;
+
+    counted_key::conversions = 0;
+
+    REQUIRE(m.try_emplace("foo"sv, 1).second);
+    REQUIRE(!m.try_emplace("foo"sv, 2).second);
+    REQUIRE(m.try_emplace(m.end(), "bar"sv, 2)->second == 2);
+    REQUIRE(counted_key::conversions == 2);
+
+    m["baz"sv] = 3;
+    m["baz"sv] += 1;
+    REQUIRE(counted_key::conversions == 3);
+
+    REQUIRE(!m.insert_or_assign("foo"sv, 10).second);
+    REQUIRE(m.insert_or_assign(m.end(), "qux"sv, 5)->second == 5);
+    REQUIRE(counted_key::conversions == 4);
+
+    REQUIRE(m.at("foo"sv) == 10);
+    REQUIRE(std::as_const(m).at("baz"sv) == 4);
+    REQUIRE_THROWS_AS(m.at("none"sv), std::out_of_range);
+
+    const auto hash = m.hash_key("bar"sv);
+    REQUIRE(m.find("bar"sv, hash)->second == 2);
+    REQUIRE(m.contains("bar"sv, hash));
+    REQUIRE(m.count("qux"sv) == 1);
+
+    REQUIRE(m.erase("bar"sv, hash) == 1);
+    REQUIRE(m.erase("qux"sv) == 1);
+    REQUIRE(m.erase("qux"sv) == 0);
+    REQUIRE(m.size() == 2);
+    REQUIRE(counted_key::conversions == 4);
+
+    REQUIRE(m.try_emplace("new"sv, m.hash_key("new"sv), 6).second);
+    REQUIRE(m.at("new"sv) == 6);
+    REQUIRE(counted_key::conversions == 5);
+
+    m.erase(m.find("new"sv));
+    REQUIRE(m.size() == 2);
+}
+
+TEST_CASE("upsert and visit")
+{
+    SECTION("upsert")
+    {
+        int hash_count = 0;
+        jg::dense_hash_map<std::string, int, counting_hash> m(8u, counting_hash{&hash_count});
+
+        REQUIRE(m.upsert(std::string("a"), 1, std::plus<>{}).second);
+        REQUIRE(!m.upsert(std::string("a"), 2, std::plus<>{}).second);
+        REQUIRE(m.upsert("b", 5, [](int& mapped, int value) { mapped *= value; }).second);
+        const auto result = m.upsert("b", 5, [](int& mapped, int value) { mapped *= value; });
+        REQUIRE(!result.second);
+        REQUIRE(result.first->second == 25);
+        REQUIRE(m.at("a") == 3);
+        REQUIRE(hash_count == 5);
+    }
+
+    SECTION("try_emplace_or_visit")
+    {
+        jg::dense_hash_map<std::string, std::vector<int>> m;
+        const auto append = [](std::vector<int>& values) { values.push_back(0); };
+
+        REQUIRE(m.try_emplace_or_visit("a", std::tuple{3u, 7}, append).second);
+        REQUIRE(!m.try_emplace_or_visit("a", std::tuple{3u, 7}, append).second);
+        REQUIRE(m.at("a") == std::vector<int>{7, 7, 7, 0});
+    }
+
+    SECTION("batched forms")
+    {
+        std::vector<std::pair<std::string, int>> pairs;
+        std::unordered_map<std::string, int> expected;
+        for (int i = 0; i < 1000; ++i)
+        {
+            pairs.emplace_back(std::to_string(i % 300), i);
+            expected[std::to_string(i % 300)] += i;
+        }
+
+        jg::dense_hash_map<std::string, int> m;
+        REQUIRE(m.upsert_many(pairs.begin(), pairs.end(), std::plus<>{}) == 300);
+        REQUIRE(m.upsert_many(pairs.begin(), pairs.begin() + 10, std::plus<>{}) == 0);
+        for (int i = 0; i < 10; ++i)
+        {
+            expected[std::to_string(i)] += i;
+        }
+
+        REQUIRE(m.size() == expected.size());
+        for (const auto& [key, value] : expected)
+        {
+            REQUIRE(m.at(key) == value);
+        }
+
+        std::vector<std::string> keys;
+        for (int i = 0; i < 100; ++i)
+        {
+            keys.push_back(std::to_string(i % 40));
+        }
+
+        jg::dense_hash_map<std::string, int> counts;
+        const auto increment = [](int& count) { ++count; };
+        REQUIRE(
+            counts.try_emplace_or_visit_many(keys.begin(), keys.end(), std::tuple{1}, increment) ==
+            40);
+        REQUIRE(counts.at("0") == 3);
+        REQUIRE(counts.at("39") == 2);
+
+        const char* literals[] = {"0", "foo", "foo"};
+        REQUIRE(
+            counts.try_emplace_or_visit_many(
+                std::begin(literals), std::end(literals), std::tuple{1}, increment) == 1);
+        REQUIRE(counts.at("0") == 4);
+        REQUIRE(counts.at("foo") == 2);
+    }
+}
+
+TEST_CASE("hash aggregator")
+{
+    std::vector<std::string> keys;
+    std::vector<int> values;
+    for (int i = 0; i < 1000; ++i)
+    {
+        keys.push_back(std::to_string((i * 7) % 90));
+        values.push_back(i - 500);
+    }
+
+    std::unordered_map<std::string, int> sums;
+    std::unordered_map<std::string, std::size_t> counts;
+    std::unordered_map<std::string, int> mins;
+    std::unordered_map<std::string, int> maxs;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        sums[keys[i]] += values[i];
+        ++counts[keys[i]];
+        auto& min = mins.try_emplace(keys[i], values[i]).first->second;
+        min = std::min(min, values[i]);
+        auto& max = maxs.try_emplace(keys[i], values[i]).first->second;
+        max = std::max(max, values[i]);
+    }
+
+    const auto check = [&](auto aggregator, const auto& expected) {
+        REQUIRE(aggregator.empty());
+
+        // Split in uneven batches, the way columns of rows come in.
+        aggregator.consume(keys.begin(), keys.begin() + 333, values.begin());
+        aggregator.consume(keys.begin() + 333, keys.end(), values.begin() + 333);
+
+        REQUIRE(aggregator.size() == expected.size());
+        for (const auto& [key, result] : aggregator.groups())
+        {
+            REQUIRE(result == expected.at(key));
+        }
+
+        std::vector<std::string> group_keys;
+        std::vector<typename decltype(aggregator)::result_type> results;
+        aggregator.export_columns(std::back_inserter(group_keys), std::back_inserter(results));
+        REQUIRE(group_keys.size() == expected.size());
+        REQUIRE(group_keys.front() == keys.front());
+        for (std::size_t i = 0; i < group_keys.size(); ++i)
+        {
+            REQUIRE(results[i] == expected.at(group_keys[i]));
+        }
+
+        const auto groups = aggregator.release();
+        REQUIRE(groups.size() == expected.size());
+        REQUIRE(aggregator.empty());
+    };
+
+    check(jg::hash_aggregator<std::string, int, jg::sum_aggregate>{}, sums);
+    check(jg::hash_aggregator<std::string, int, jg::count_aggregate>{100u}, counts);
+    check(jg::hash_aggregator<std::string, int, jg::min_aggregate>{}, mins);
+    check(jg::hash_aggregator<std::string, int, jg::max_aggregate>{}, maxs);
+}